@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+# ################################################################### #
+# Copyright 2015, Pierre Gentile (p.gen.progs@gmail.com)              #
+#                                                                     #
+# This Source Code Form is subject to the terms of the Mozilla Public #
+# License, v. 2.0. If a copy of the MPL was not distributed with this #
+# file, You can obtain one at https://mozilla.org/MPL/2.0/.           #
+# ################################################################### #
+
+# Generates width.c from the Unicode data known by the unicodedata module.
+# The widths follow the rules used by the GNU C library to build the
+# wcwidth table of its UTF-8 locales:
+#   -1 for the control, surrogate, unassigned and line/paragraph separator
+#      code points,
+#    0 for the combining and format characters and the Hangul medial
+#      vowels and final consonants,
+#    2 for the wide and fullwidth East Asian characters,
+#    1 for everything else.
+#
+# Usage: build-aux/gen_width.py > width.c
+
+import sys
+import unicodedata
+
+# Code points having the Prepended_Concatenation_Mark property (PropList.txt),
+# they are visible even if they are format characters.
+PREPENDED_CONCATENATION_MARKS = {
+    0x0600, 0x0601, 0x0602, 0x0603, 0x0604, 0x0605, 0x06DD, 0x070F,
+    0x0890, 0x0891, 0x08E2, 0x110BD, 0x110CD
+}
+
+
+def width(cp):
+    ch = chr(cp)
+    cat = unicodedata.category(ch)
+
+    if cp == 0:
+        return 0
+    if cat in ("Cc", "Cs", "Cn", "Zl", "Zp"):
+        return -1
+    if cp in PREPENDED_CONCATENATION_MARKS:
+        return 1
+    if (cat in ("Mn", "Me")
+            or (cat == "Cf" and cp != 0x00AD)
+            or 0x1160 <= cp <= 0x11FF
+            or 0xD7B0 <= cp <= 0xD7FF
+            or cp == 0x200B):
+        return 0
+    if (unicodedata.east_asian_width(ch) in ("W", "F")
+            or 0x3248 <= cp <= 0x324F
+            or 0x4DC0 <= cp <= 0x4DFF):
+        return 2
+    return 1
+
+
+def banner():
+    lines = ["This file is generated by build-aux/gen_width.py from the",
+             "Unicode %s data, do not edit it." % unicodedata.unidata_version]
+    size = max(len(line) for line in lines)
+    text = "".join("/* %-*s */\n" % (size, line) for line in lines)
+    return text + "/* %s */\n" % ('"' * size)
+
+
+def main():
+    blocks = []
+    index = []
+    known = {}
+
+    for base in range(0, 0x110000, 256):
+        packed = bytearray(64)
+        for cp in range(base, base + 256):
+            code = width(cp) & 3  # -1 is stored as 3.
+            packed[(cp & 0xFF) >> 2] |= code << ((cp & 3) * 2)
+        packed = bytes(packed)
+        if packed not in known:
+            known[packed] = len(blocks)
+            blocks.append(packed)
+        index.append(known[packed])
+
+    if len(blocks) > 256:
+        sys.exit("too many distinct blocks")
+
+    out = sys.stdout
+    out.write('''\
+/* ################################################################### */
+/* Copyright 2015, Pierre Gentile (p.gen.progs@gmail.com)              */
+/*                                                                     */
+/* This Source Code Form is subject to the terms of the Mozilla Public */
+/* License, v. 2.0. If a copy of the MPL was not distributed with this */
+/* file, You can obtain one at https://mozilla.org/MPL/2.0/.           */
+/* ################################################################### */
+
+%s
+#include <stddef.h> /* for wchar_t */
+#include "width.h"
+
+/* Number of the block of width_blocks describing each group of 256 */
+/* consecutive code points.                                         */
+/* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+static const unsigned char width_index[%d] = {
+''' % (banner(), len(index)))
+
+    for i in range(0, len(index), 12):
+        out.write("  " + ", ".join("%3d" % v for v in index[i:i + 12])
+                  + ",\n")
+    out.write("};\n\n")
+
+    out.write('''\
+/* Widths of the 256 code points of a block, 2 bits per code point, */
+/* the value 3 meaning -1.                                          */
+/* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+static const unsigned char width_blocks[%d][64] = {
+''' % len(blocks))
+
+    for block in blocks:
+        out.write("  {\n")
+        for i in range(0, 64, 12):
+            out.write("    " + ", ".join("0x%02x" % v for v in block[i:i + 12])
+                      + ",\n")
+        out.write("  },\n")
+    out.write("};\n")
+
+    out.write('''
+/* ================================================================== */
+/* Returns the number of screen positions taken by the code point wc, */
+/* 0 for the combining characters and -1 for the non printable ones.  */
+/* Unlike wcwidth, the result does not depend on the current locale.  */
+/* ================================================================== */
+int
+my_wcwidth(wchar_t wc)
+{
+  static const int widths[4] = { 0, 1, 2, -1 };
+  unsigned long    cp        = (unsigned long)wc;
+
+  if (cp > 0x10ffff)
+    return -1;
+
+  return widths[(width_blocks[width_index[cp >> 8]][(cp & 0xff) >> 2]
+                  >> ((cp & 3) * 2))
+                 & 3];
+}
+''')
+
+
+main()
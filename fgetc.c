@@ -6,65 +6,159 @@
 /* file, You can obtain one at https://mozilla.org/MPL/2.0/.           */
 /* ################################################################### */
 
-/* ************************************************************************* */
-/* Custom fgetc/ungetc implementation able to unget more than one character. */
-/* ************************************************************************* */
+/* ******************************************************************* */
+/* Custom fgetc implementation and block-buffered input reader able to */
+/* unget more than one character.                                      */
+/* ******************************************************************* */
 
 #include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "xmalloc.h"
 #include "fgetc.h"
 
-enum
-{
-  GETC_BUFF_SIZE = 16
-};
-
-static unsigned char getc_buffer[GETC_BUFF_SIZE] = { '\0' };
-
-static int next_buffer_pos = 0; /* Next free position in the getc buffer. */
-
-/* ======================================== */
-/* Gets a (possibly pushed-back) character. */
-/* ======================================== */
+/* ================================================================ */
+/* Gets a character, retrying while the input is not yet available. */
+/* ================================================================ */
 int
 my_fgetc(FILE *input)
 {
-  if (next_buffer_pos > 0)
-    return getc_buffer[--next_buffer_pos];
-  else
-  {
-    int c;
+  int c;
+
+  errno = 0;
+  c     = fgetc(input);
 
+  while (c == EOF && errno == EAGAIN)
+  {
     errno = 0;
     c     = fgetc(input);
+  }
 
-    while (c == EOF && errno == EAGAIN)
+  return c;
+}
+
+/* ===================================================================== */
+/* Creates a new block-buffered reader on the file descriptor of the     */
+/* stream input. Nothing must have been read from input with stdio       */
+/* functions before.                                                     */
+/* If input is a non empty regular file, it is mapped in memory instead  */
+/* so that its bytes are read in place. The mapping is private and       */
+/* writable so the words can be nul-terminated directly in it, each page */
+/* written that way becomes a private copy.                              */
+/* The file must not be truncated by another process while it is mapped. */
+/* ===================================================================== */
+in_buf_t *
+in_buf_new(FILE *input)
+{
+  in_buf_t   *ib = xmalloc(sizeof(in_buf_t));
+  struct stat st;
+
+  ib->fd     = fileno(input);
+  ib->mapped = 0;
+  ib->eof    = 0;
+
+  if (fstat(ib->fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+  {
+    off_t offset = lseek(ib->fd, 0, SEEK_CUR);
+    void *map;
+
+    if (offset >= 0 && offset < st.st_size)
     {
-      errno = 0;
-      c     = fgetc(input);
-    }
+      map = mmap(NULL,
+                 (size_t)st.st_size,
+                 PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE,
+                 ib->fd,
+                 0);
+
+      if (map != MAP_FAILED)
+      {
+        /* Let the system read the file in the background while the */
+        /* first words are being tokenized.                         */
+        /* """""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+        (void)posix_madvise(map, (size_t)st.st_size, POSIX_MADV_WILLNEED);
+
+        ib->data   = map;
+        ib->pos    = (size_t)offset;
+        ib->end    = (size_t)st.st_size;
+        ib->eof    = 1;
+        ib->mapped = 1;
 
-    return c;
+        return ib;
+      }
+    }
   }
+
+  ib->data = xmalloc(IN_UNGET_SIZE + IN_BUF_SIZE);
+  ib->pos  = IN_UNGET_SIZE;
+  ib->end  = IN_UNGET_SIZE;
+
+  return ib;
 }
 
-/* =============================== */
-/* Pushes character back on input. */
-/* =============================== */
+/* ==================================================================== */
+/* Frees the memory used by a buffered reader. A memory mapped input is */
+/* unmapped, so no word pointing inside it must be in use anymore.      */
+/* ==================================================================== */
+void
+in_buf_free(in_buf_t *ib)
+{
+  if (ib->mapped)
+    munmap(ib->data, ib->end);
+  else
+    free(ib->data);
+
+  free(ib);
+}
+
+/* ===================================================================== */
+/* Refills the buffer with the next block of input and returns its first */
+/* byte or EOF. Only called by IN_BUF_GETC when the buffer is exhausted. */
+/* The unget area located before the data block is kept untouched.       */
+/* ===================================================================== */
 int
-my_ungetc(int c, FILE *input)
+in_buf_fill(in_buf_t *ib)
 {
-  int rc;
+  ssize_t n;
 
-  if (next_buffer_pos >= GETC_BUFF_SIZE)
-    rc = EOF;
-  else
+  if (ib->eof)
+    return EOF;
+
+  do
+    n = read(ib->fd, ib->data + IN_UNGET_SIZE, IN_BUF_SIZE);
+  while (n < 0 && (errno == EINTR || errno == EAGAIN));
+
+  if (n <= 0)
   {
-    rc = getc_buffer[next_buffer_pos++] = (unsigned char)c;
+    ib->eof = 1;
+    ib->pos = ib->end = IN_UNGET_SIZE;
 
-    if (feof(input))
-      clearerr(input); /* No more EOF. */
+    return EOF;
   }
 
-  return rc;
+  ib->pos = IN_UNGET_SIZE;
+  ib->end = IN_UNGET_SIZE + (size_t)n;
+
+  return ib->data[ib->pos++];
+}
+
+/* ====================================================================== */
+/* Pushes character back on input. Returns EOF if the unget area is full. */
+/* ====================================================================== */
+int
+in_buf_ungetc(int c, in_buf_t *ib)
+{
+  if (ib->pos == 0)
+    return EOF;
+
+  /* Avoid writing in the buffer when the byte pushed back is the one */
+  /* just read, a memory mapped page then stays clean.                */
+  /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+  if (ib->data[--ib->pos] != (unsigned char)c)
+    ib->data[ib->pos] = (unsigned char)c;
+
+  return (unsigned char)c;
 }
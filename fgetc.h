@@ -11,10 +11,47 @@
 
 #include <stdio.h>
 
+typedef struct in_buf_s in_buf_t;
+
+enum
+{
+  IN_BUF_SIZE   = 65536, /* size of a block read by read(2).          */
+  IN_UNGET_SIZE = 64     /* number of bytes which can be pushed back. */
+};
+
+/* Block-buffered input reader. */
+/* """""""""""""""""""""""""""" */
+struct in_buf_s
+{
+  int            fd;     /* file descriptor to read from.                */
+  unsigned char *data;   /* unget area followed by the data block or the *
+                          | memory mapped input.                         */
+  size_t         pos;    /* offset of the next byte to return.           */
+  size_t         end;    /* offset just after the last available byte.   */
+  int            eof;    /* 1 when no more bytes can be read.            */
+  int            mapped; /* 1 if data is a private memory mapping of the *
+                          | whole input file.                            */
+};
+
+/* Gets the next byte from the buffered reader ib, refills the buffer */
+/* when it is exhausted.                                              */
+/* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+#define IN_BUF_GETC(ib) \
+  ((ib)->pos < (ib)->end ? (ib)->data[(ib)->pos++] : in_buf_fill(ib))
+
 int
 my_fgetc(FILE *input);
 
+in_buf_t *
+in_buf_new(FILE *input);
+
+void
+in_buf_free(in_buf_t *ib);
+
+int
+in_buf_fill(in_buf_t *ib);
+
 int
-my_ungetc(int c, FILE *input);
+in_buf_ungetc(int c, in_buf_t *ib);
 
 #endif
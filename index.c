@@ -15,20 +15,56 @@
 /*   https://www.cs.princeton.edu/~rs/strings/tstdemo.c.                    */
 /* ************************************************************************ */
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
-#include <wctype.h>
 #include <string.h>
 #include <wchar.h>
 
 #include "xmalloc.h"
 #include "list.h"
+#include "utf8.h"
 #include "index.h"
 
 /* List of words matching the current search. */
 /* """""""""""""""""""""""""""""""""""""""""" */
 ll_t *tst_search_list; /* Must be initialized by ll_new() before use. */
 
+/* Pool of nodes shared by all the ternary search trees.               */
+/* The nodes are allocated by blocks which are never moved, so that    */
+/* their addresses remain valid, and designated by a 32-bit index in   */
+/* this pool. The index 0 is never allocated and means "no child".     */
+/* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+enum
+{
+  TST_BLOCK_SHIFT = 14,
+  TST_BLOCK_SIZE  = 1 << TST_BLOCK_SHIFT /* number of nodes in a block. */
+};
+
+#define TST_NODE(i) \
+  (tst_blocks[(i) >> TST_BLOCK_SHIFT] + ((i) & (TST_BLOCK_SIZE - 1)))
+#define TST_CHILD(i) ((i) != 0 ? TST_NODE(i) : NULL)
+
+static tst_node_t **tst_blocks;          /* array of node blocks.         */
+static uint32_t     tst_blocks_size = 0; /* allocated size of tst_blocks. */
+static uint32_t     tst_nb_nodes    = 1; /* index of the next free node.  */
+
+/* Explicit stack used by the iterative traversals, it is kept between */
+/* calls to avoid allocating it each time.                             */
+/* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+typedef struct tst_stack_s tst_stack_t;
+
+struct tst_stack_s
+{
+  tst_node_t *node;  /* node to process.                                */
+  int         visit; /* 1 if only the data attached to node remains to  *
+                      | be visited.                                     */
+  long        depth; /* depth of node in its word, only used by sa_new. */
+};
+
+static tst_stack_t *tst_stack;
+static long         tst_stack_size = 0;
+
 /* ==================================================== */
 /* Private implementation of wcscasecmp missing in c99. */
 /* ==================================================== */
@@ -39,8 +75,8 @@ my_wcscasecmp(const wchar_t *s1, const wchar_t *s2)
   {
     wchar_t c1, c2;
 
-    c1 = towlower(*s1);
-    c2 = towlower(*s2);
+    c1 = wc_fold(*s1);
+    c2 = wc_fold(*s2);
 
     if (c1 != c2)
       return (int)(c1 - c2);
@@ -51,197 +87,1021 @@ my_wcscasecmp(const wchar_t *s1, const wchar_t *s2)
   return -*s2;
 }
 
-/* ======================================= */
-/* Ternary search tree insertion function. */
-/* ======================================= */
-tst_node_t *
-tst_insert(tst_node_t *p, wchar_t *w, void *data)
+/* ======================================================= */
+/* Allocates a new node in the pool and returns its index. */
+/* ======================================================= */
+static uint32_t
+tst_node_new(wchar_t splitchar)
+{
+  tst_node_t *p;
+  uint32_t    i = tst_nb_nodes;
+
+  if (i == UINT32_MAX)
+  {
+    fprintf(stderr, "Error: Too many nodes in the search index.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  if ((i >> TST_BLOCK_SHIFT) == tst_blocks_size)
+  {
+    tst_blocks_size += 64;
+    tst_blocks = xrealloc(tst_blocks, tst_blocks_size * sizeof(tst_node_t *));
+  }
+
+  if ((i & (TST_BLOCK_SIZE - 1)) == 0 || i == 1)
+    tst_blocks[i >> TST_BLOCK_SHIFT] = xmalloc(TST_BLOCK_SIZE
+                                               * sizeof(tst_node_t));
+
+  tst_nb_nodes++;
+
+  p            = TST_NODE(i);
+  p->splitchar = splitchar;
+  p->lokid = p->eqkid = p->hikid = 0;
+  p->data                        = NULL;
+
+  return i;
+}
+
+/* ===================================================================== */
+/* Looks for w in the ternary search tree whose root is *root and        */
+/* creates the missing nodes on the way if it is not there, *root being  */
+/* set if the tree was empty.                                            */
+/* The tree is walked down only once and iteratively, so the length of   */
+/* the string is not limited by the stack depth.                         */
+/* Returns the address of the data slot attached to w, which contains    */
+/* NULL if w has just been inserted.                                     */
+/* ===================================================================== */
+void **
+tst_insert_or_get(tst_node_t **root, wchar_t *w)
 {
+  tst_node_t *p = *root;
+  uint32_t    i;
+
   if (p == NULL)
   {
-    p            = (tst_node_t *)xmalloc(sizeof(tst_node_t));
-    p->splitchar = *w;
-    p->lokid = p->eqkid = p->hikid = NULL;
-    p->data                        = NULL;
+    i     = tst_node_new(*w);
+    p     = TST_NODE(i);
+    *root = p;
   }
 
-  if (*w < p->splitchar)
-    p->lokid = tst_insert(p->lokid, w, data);
-  else if (*w == p->splitchar)
+  for (;;)
   {
-    if (*w == L'\0')
+    if (*w < p->splitchar)
+    {
+      if (p->lokid == 0)
+        p->lokid = tst_node_new(*w);
+      p = TST_NODE(p->lokid);
+    }
+    else if (*w == p->splitchar)
     {
-      p->data  = data;
-      p->eqkid = NULL;
+      if (*w == L'\0')
+        return &p->data;
+
+      w++;
+      if (p->eqkid == 0)
+        p->eqkid = tst_node_new(*w);
+      p = TST_NODE(p->eqkid);
     }
     else
-      p->eqkid = tst_insert(p->eqkid, w + 1, data);
+    {
+      if (p->hikid == 0)
+        p->hikid = tst_node_new(*w);
+      p = TST_NODE(p->hikid);
+    }
   }
-  else
-    p->hikid = tst_insert(p->hikid, w, data);
+}
 
-  return (p);
+/* ============================================================ */
+/* Ternary search tree insertion function.                      */
+/* Returns the root of the tree, which is created if p is NULL. */
+/* ============================================================ */
+tst_node_t *
+tst_insert(tst_node_t *p, wchar_t *w, void *data)
+{
+  *tst_insert_or_get(&p, w) = data;
+
+  return p;
 }
 
-/* ====================================== */
-/* Ternary search tree deletion function. */
-/* User data area not cleaned.            */
-/* ====================================== */
+/* ===================================================================== */
+/* Inserts n keys, sorted and without duplicates, in a ternary search    */
+/* tree. The medians are inserted first so that the tree remains         */
+/* balanced even when the keys come in order, which is the common case   */
+/* with sorted inputs. Inserting them one after the other would turn the */
+/* lokid/hikid chains into linked lists.                                 */
+/* The key strings are not kept in the tree.                             */
+/* ===================================================================== */
+tst_node_t *
+tst_build(tst_node_t *p, tst_key_t *keys, long n)
+{
+  long     mid;
+  wchar_t *w;
+
+  if (n <= 0)
+    return p;
+
+  mid = n / 2;
+
+  w = utf8_strtowcs(keys[mid].str);
+  p = tst_insert(p, w, keys[mid].data);
+  free(w);
+
+  p = tst_build(p, keys, mid);
+  p = tst_build(p, keys + mid + 1, n - mid - 1);
+
+  return p;
+}
+
+/* ================================================================= */
+/* Creates a posting list from the n positions in pos, which must be */
+/* sorted in increasing order.                                       */
+/* ================================================================= */
+posting_t *
+posting_new(long *pos, long n)
+{
+  posting_t     *posting;
+  size_t         size = 0;
+  unsigned char *p;
+  unsigned long  gap;
+
+  for (long i = 1; i < n; i++)
+    for (gap = pos[i] - pos[i - 1]; size++, gap >= 0x80; gap >>= 7)
+      ;
+
+  posting        = xmalloc(sizeof(posting_t) + size);
+  posting->first = pos[0];
+  posting->count = n;
+
+  p = posting->gaps;
+  for (long i = 1; i < n; i++)
+  {
+    for (gap = pos[i] - pos[i - 1]; gap >= 0x80; gap >>= 7)
+      *p++ = (unsigned char)(gap | 0x80);
+    *p++ = (unsigned char)gap;
+  }
+
+  return posting;
+}
+
+/* ======================================= */
+/* Prepares the reading of a posting list. */
+/* ======================================= */
 void
-tst_cleanup(tst_node_t *p)
+posting_iter_init(posting_iter_t *it, posting_t *posting)
 {
-  if (p != NULL)
+  it->posting   = posting;
+  it->remaining = posting->count;
+  it->pos       = posting->first;
+  it->next      = posting->gaps;
+}
+
+/* ============================================================= */
+/* Stores the next position of the posting list in *pos.         */
+/* Returns 0 when all the positions have been read, 1 otherwise. */
+/* ============================================================= */
+int
+posting_iter_next(posting_iter_t *it, long *pos)
+{
+  unsigned long gap   = 0;
+  int           shift = 0;
+
+  if (it->remaining == 0)
+    return 0;
+
+  if (it->remaining-- < it->posting->count)
   {
-    tst_cleanup(p->lokid);
-    if (p->splitchar != L'\0')
-      tst_cleanup(p->eqkid);
-    tst_cleanup(p->hikid);
-    free(p);
+    do
+    {
+      gap |= (unsigned long)(*it->next & 0x7f) << shift;
+      shift += 7;
+    } while (*it->next++ & 0x80);
+
+    it->pos += gap;
   }
+
+  *pos = it->pos;
+
+  return 1;
+}
+
+/* ===================================================================== */
+/* Pushes an entry on the traversal stack, growing it when needed.       */
+/* ===================================================================== */
+static void
+tst_push(long *n, tst_node_t *node, int visit, long depth)
+{
+  if (*n == tst_stack_size)
+  {
+    tst_stack_size += 256;
+    tst_stack = xrealloc(tst_stack, tst_stack_size * sizeof(tst_stack_t));
+  }
+
+  tst_stack[*n].node  = node;
+  tst_stack[*n].visit = visit;
+  tst_stack[*n].depth = depth;
+  (*n)++;
+}
+
+/* ====================================================================== */
+/* Iterative traversal of a ternary tree using an explicit stack.         */
+/* The nodes are processed in the same order as a recursive traversal     */
+/* would do: the node itself, then its lokid, eqkid and hikid sub-trees.  */
+/* A callback function, if any, is called when a complete string is found */
+/* with the data attached to it.                                          */
+/* In the TST_WALK_SUBSTRING and TST_WALK_FUZZY modes, the eqkid of each  */
+/* node whose splitchar is w (case insensitively in TST_WALK_FUZZY mode)  */
+/* is also added to the sub_tst_t at the tail of tst_search_list.         */
+/* Returns 1 if a node matched or if the callback function succeed        */
+/* (returned 1) at least once.                                            */
+/* ====================================================================== */
+enum
+{
+  TST_WALK_ALL,
+  TST_WALK_SUBSTRING,
+  TST_WALK_FUZZY
+};
+
+static int
+tst_walk(tst_node_t *p, int (*callback)(void *), int mode, wchar_t w)
+{
+  int         rc = 0;
+  long        n  = 0;
+  tst_node_t *q;
+  wchar_t     lw = wc_fold(w);
+  sub_tst_t  *sub_tst_data = NULL;
+
+  if (p == NULL)
+    return 0;
+
+  if (mode != TST_WALK_ALL)
+    sub_tst_data = (sub_tst_t *)(tst_search_list->tail->data);
+
+  tst_push(&n, p, 0, 0);
+
+  while (n > 0)
+  {
+    n--;
+    q = tst_stack[n].node;
+
+    if (tst_stack[n].visit)
+    {
+      rc += (*callback)(q->data);
+      continue;
+    }
+
+    if ((mode == TST_WALK_SUBSTRING && q->splitchar == w)
+        || (mode == TST_WALK_FUZZY && wc_fold(q->splitchar) == lw))
+    {
+      if (q->eqkid != 0)
+        insert_sorted_ptr(&(sub_tst_data->array),
+                          &(sub_tst_data->size),
+                          &(sub_tst_data->count),
+                          TST_NODE(q->eqkid));
+
+      rc = 1;
+    }
+
+    /* Push in reverse order so that lokid is processed first. */
+    /* """"""""""""""""""""""""""""""""""""""""""""""""""""""" */
+    if (q->hikid != 0)
+      tst_push(&n, TST_NODE(q->hikid), 0, 0);
+
+    if (q->splitchar != L'\0')
+    {
+      if (q->eqkid != 0)
+        tst_push(&n, TST_NODE(q->eqkid), 0, 0);
+    }
+    else if (callback != NULL)
+      tst_push(&n, q, 1, 0);
+
+    if (q->lokid != 0)
+      tst_push(&n, TST_NODE(q->lokid), 0, 0);
+  }
+
+  return !!rc;
 }
 
 /* ========================================================== */
-/* Recursive traversal of a ternary tree. A callback function */
-/* is also called when a complete string is found.            */
+/* Traversal of a ternary tree. A callback function is called */
+/* when a complete string is found.                           */
 /* Returns 1 if the callback function succeed (returned 1) at */
 /* least once.                                                */
-/* The first_call argument is for initializing the static     */
-/* variable.                                                  */
 /* ========================================================== */
 int
-tst_traverse(tst_node_t *p, int (*callback)(void *), int first_call)
+tst_traverse(tst_node_t *p, int (*callback)(void *))
 {
-  static int rc;
+  return tst_walk(p, callback, TST_WALK_ALL, L'\0');
+}
 
-  if (first_call)
-    rc = 0;
+/* ====================================================================== */
+/* Sorts the n suffixes whose offsets in text are in a, knowing that they */
+/* all share their first depth bytes.                                     */
+/* This is the multikey quicksort of Bentley and Sedgewick: the suffixes  */
+/* are partitioned on their byte at depth and only the ones equal to the  */
+/* pivot need to be compared further. A suffix ends with the '\0' which   */
+/* terminates its key.                                                    */
+/* ====================================================================== */
+static void
+sa_sort(uint32_t *a, long n, long depth, const unsigned char *text)
+{
+  long     lt, gt, i, j;
+  long     nb_lt, nb_eq, nb_gt; /* sizes of the three partitions. */
+  int      pivot, c;
+  uint32_t t;
 
-  if (p == NULL)
-    return 0;
-  tst_traverse(p->lokid, callback, 0);
-  if (p->splitchar != L'\0')
-    tst_traverse(p->eqkid, callback, 0);
-  else
-    rc += (*callback)(p->data);
-  tst_traverse(p->hikid, callback, 0);
+  while (n > 1)
+  {
+    /* Insertion sort for the small partitions. */
+    /* """""""""""""""""""""""""""""""""""""""" */
+    if (n < 16)
+    {
+      for (i = 1; i < n; i++)
+        for (j = i; j > 0
+                    && strcmp((const char *)text + a[j - 1] + depth,
+                              (const char *)text + a[j] + depth)
+                         > 0;
+             j--)
+        {
+          t        = a[j];
+          a[j]     = a[j - 1];
+          a[j - 1] = t;
+        }
 
-  return !!rc;
+      return;
+    }
+
+    /* The pivot is the byte of the middle suffix. The suffixes are */
+    /* in text order, so no fixed position is better than another,  */
+    /* the three-way partition deals with the runs of equal bytes.  */
+    /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+    t        = a[0];
+    a[0]     = a[n / 2];
+    a[n / 2] = t;
+
+    pivot = text[a[0] + depth];
+
+    /* Three-way partition: [0,lt) < pivot, [lt,gt] == pivot and */
+    /* (gt,n) > pivot.                                           */
+    /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+    lt = 0;
+    gt = n - 1;
+    i  = 1;
+
+    while (i <= gt)
+    {
+      c = text[a[i] + depth];
+
+      if (c < pivot)
+      {
+        t       = a[lt];
+        a[lt++] = a[i];
+        a[i++]  = t;
+      }
+      else if (c > pivot)
+      {
+        t       = a[gt];
+        a[gt--] = a[i];
+        a[i]    = t;
+      }
+      else
+        i++;
+    }
+
+    /* The suffixes equal to the pivot are sorted on their next byte, */
+    /* there is nothing left to compare if the pivot ends them.        */
+    /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+    nb_lt = lt;
+    nb_eq = pivot != '\0' ? gt - lt + 1 : 0;
+    nb_gt = n - gt - 1;
+
+    /* Recurse on the two smallest partitions and loop on the largest */
+    /* one, so that the recursion depth stays in O(log(n)).           */
+    /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+    if (nb_lt >= nb_eq && nb_lt >= nb_gt)
+    {
+      sa_sort(a + lt, nb_eq, depth + 1, text);
+      sa_sort(a + gt + 1, nb_gt, depth, text);
+
+      n = nb_lt;
+    }
+    else if (nb_gt >= nb_eq)
+    {
+      sa_sort(a, nb_lt, depth, text);
+      sa_sort(a + lt, nb_eq, depth + 1, text);
+
+      a += gt + 1;
+      n = nb_gt;
+    }
+    else
+    {
+      sa_sort(a, nb_lt, depth, text);
+      sa_sort(a + gt + 1, nb_gt, depth, text);
+
+      a += lt;
+      n = nb_eq;
+      depth++;
+    }
+  }
 }
 
-/* ======================================================== */
-/* Allocates and returns a newly created sub_tst_t element. */
-/* ======================================================== */
-sub_tst_t *
-sub_tst_new(void)
+/* ====================================================================== */
+/* Rebuilds in UTF-8 the keys stored in the ternary search tree root by   */
+/* walking it in order. The keys are stored one after the other, each     */
+/* followed by a '\0', in *text whose length is set in *text_len.         */
+/* The offset in *text and the data of each key are stored in *starts     */
+/* and *data and their number in *nb_keys.                                */
+/* The characters are lowercased when fold is not 0.                      */
+/* Returns 0 if the keys are too large to be indexed with 32-bit offsets, */
+/* nothing is allocated in this case.                                     */
+/* ====================================================================== */
+static int
+tst_flatten(tst_node_t     *root,
+            int             fold,
+            unsigned char **text,
+            size_t         *text_len,
+            uint32_t      **starts,
+            void         ***data,
+            uint32_t       *nb_keys)
 {
-  sub_tst_t *elem = xmalloc(sizeof(sub_tst_t));
+  tst_node_t *q;
+  wchar_t    *path      = NULL; /* characters of the current key. */
+  long        path_size = 0;
+  long        depth;
+  long        n         = 0;
+  size_t      text_size = 0;
+  uint32_t    keys_size = 0;
 
-  elem->size  = 64;
-  elem->count = 0;
-  elem->array = xmalloc(elem->size * sizeof(tst_node_t));
+  *text     = NULL;
+  *text_len = 0;
+  *starts   = NULL;
+  *data     = NULL;
+  *nb_keys  = 0;
 
-  return elem;
+  if (root != NULL)
+    tst_push(&n, root, 0, 0);
+
+  /* In-order walk of the tree, a node is visited twice: once to  */
+  /* schedule its lokid, itself and its hikid, then again to note */
+  /* its character in path and schedule its eqkid.                */
+  /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+  while (n > 0)
+  {
+    n--;
+    q     = tst_stack[n].node;
+    depth = tst_stack[n].depth;
+
+    if (!tst_stack[n].visit)
+    {
+      if (q->hikid != 0)
+        tst_push(&n, TST_NODE(q->hikid), 0, depth);
+      tst_push(&n, q, 1, depth);
+      if (q->lokid != 0)
+        tst_push(&n, TST_NODE(q->lokid), 0, depth);
+
+      continue;
+    }
+
+    if (depth == path_size)
+    {
+      path_size += 64;
+      path = xrealloc(path, path_size * sizeof(wchar_t));
+    }
+
+    path[depth] = q->splitchar;
+
+    if (q->splitchar != L'\0')
+    {
+      if (q->eqkid != 0)
+        tst_push(&n, TST_NODE(q->eqkid), 0, depth + 1);
+
+      continue;
+    }
+
+    /* path now contains a complete key, append it to text. */
+    /* """""""""""""""""""""""""""""""""""""""""""""""""""" */
+    if (*text_len + 4 * depth + 1 > text_size)
+    {
+      text_size = 2 * text_size + 4 * depth + 1;
+      *text     = xrealloc(*text, text_size);
+    }
+
+    if (*nb_keys == keys_size)
+    {
+      keys_size = 2 * keys_size + 64;
+      *starts   = xrealloc(*starts, keys_size * sizeof(uint32_t));
+      *data     = xrealloc(*data, keys_size * sizeof(void *));
+    }
+
+    (*starts)[*nb_keys] = *text_len;
+    (*data)[*nb_keys]   = q->data;
+    (*nb_keys)++;
+
+    for (long i = 0; i < depth; i++)
+      *text_len += cptoutf8((char *)*text + *text_len,
+                            fold ? wc_fold(path[i]) : path[i]);
+    (*text)[(*text_len)++] = '\0';
+
+    if (*text_len >= UINT32_MAX || *nb_keys == UINT32_MAX)
+    {
+      free(path);
+      free(*text);
+      free(*starts);
+      free(*data);
+
+      return 0;
+    }
+  }
+
+  free(path);
+
+  return 1;
 }
 
-/* ======================================================================= */
-/* Traverses the word tst looking for a wchar and build a list of pointers */
-/* containing all the sub-tst potentially leading to words containing the  */
-/* next wchar of the search string.                                        */
-/* ======================================================================= */
+/* ====================================================================== */
+/* Builds a suffix array over the keys stored in the ternary search tree  */
+/* root, to be used by sa_search.                                         */
+/* The suffixes starting at each character of the keys are sorted.        */
+/* Returns NULL if the keys are too large to be indexed with 32-bit       */
+/* offsets.                                                               */
+/* ====================================================================== */
+sa_t *
+sa_new(tst_node_t *root)
+{
+  sa_t  *sa;
+  size_t text_len;
+
+  sa = xcalloc(1, sizeof(sa_t));
+
+  if (!tst_flatten(root,
+                   0,
+                   &sa->text,
+                   &text_len,
+                   &sa->starts,
+                   &sa->data,
+                   &sa->nb_keys))
+  {
+    free(sa);
+
+    return NULL;
+  }
+
+  /* One suffix per character, the UTF-8 continuation bytes cannot */
+  /* start a match.                                                */
+  /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+  for (size_t i = 0; i < text_len; i++)
+    if (sa->text[i] != '\0' && (sa->text[i] & 0xc0) != 0x80)
+      sa->nb_suffixes++;
+
+  sa->suffixes = xmalloc((sa->nb_suffixes + 1) * sizeof(uint32_t));
+
+  for (size_t i = 0, j = 0; i < text_len; i++)
+    if (sa->text[i] != '\0' && (sa->text[i] & 0xc0) != 0x80)
+      sa->suffixes[j++] = i;
+
+  sa_sort(sa->suffixes, sa->nb_suffixes, 0, sa->text);
+
+  sa->stamps = xcalloc(sa->nb_keys + 1, sizeof(uint32_t));
+  sa->stamp  = 0;
+
+  return sa;
+}
+
+/* ====================================================================== */
+/* Searches all the keys of the suffix array sa containing the string w.  */
+/* The sorted suffixes beginning with w form a contiguous range which is  */
+/* found by two binary searches. The callback function is applied once to */
+/* the data of each key having at least one suffix in this range.         */
+/* Returns 1 if the callback function succeed (returned 1) at least once. */
+/* ====================================================================== */
 int
-tst_substring_traverse(tst_node_t *p,
-                       int (*callback)(void *),
-                       int     first_call,
-                       wchar_t w)
+sa_search(sa_t *sa, wchar_t *w, int (*callback)(void *))
 {
-  static int rc;
+  char    *s;
+  size_t   len = 0;
+  long     lo, hi, mid, first;
+  uint32_t off, k;
+  int      rc = 0;
 
-  if (first_call)
-    rc = 0;
+  s = xmalloc(4 * wcslen(w) + 1);
+  while (*w)
+    len += cptoutf8(s + len, *w++);
+  s[len] = '\0';
 
-  if (p == NULL)
+  if (len == 0)
+  {
+    free(s);
     return 0;
+  }
+
+  /* A new stamp to report each key only once. */
+  /* """"""""""""""""""""""""""""""""""""""""" */
+  if (++sa->stamp == 0)
+  {
+    memset(sa->stamps, 0, sa->nb_keys * sizeof(uint32_t));
+    sa->stamp = 1;
+  }
+
+  /* First suffix not lower than s. */
+  /* """""""""""""""""""""""""""""" */
+  lo = 0;
+  hi = sa->nb_suffixes;
+  while (lo < hi)
+  {
+    mid = lo + (hi - lo) / 2;
+    if (strncmp((char *)sa->text + sa->suffixes[mid], s, len) < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  first = lo;
 
-  if (p->splitchar == w)
+  /* First suffix not beginning with s. */
+  /* """""""""""""""""""""""""""""""""" */
+  hi = sa->nb_suffixes;
+  while (lo < hi)
   {
-    ll_node_t *node;
-    sub_tst_t *sub_tst_data;
+    mid = lo + (hi - lo) / 2;
+    if (strncmp((char *)sa->text + sa->suffixes[mid], s, len) <= 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
 
-    node         = tst_search_list->tail;
-    sub_tst_data = (sub_tst_t *)(node->data);
+  for (long i = first; i < lo; i++)
+  {
+    long l = 0, h = sa->nb_keys;
 
-    if (p->eqkid != NULL)
-      insert_sorted_ptr(&(sub_tst_data->array),
-                        &(sub_tst_data->size),
-                        &(sub_tst_data->count),
-                        p->eqkid);
+    /* Find the key containing this suffix: the last one starting */
+    /* at or before it.                                           */
+    /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+    off = sa->suffixes[i];
+    while (h - l > 1)
+    {
+      mid = l + (h - l) / 2;
+      if (sa->starts[mid] <= off)
+        l = mid;
+      else
+        h = mid;
+    }
+    k = l;
 
-    rc = 1;
+    if (sa->stamps[k] != sa->stamp)
+    {
+      sa->stamps[k] = sa->stamp;
+      rc += (*callback)(sa->data[k]);
+    }
   }
 
-  tst_substring_traverse(p->lokid, callback, 0, w);
-  if (p->splitchar != L'\0')
-    tst_substring_traverse(p->eqkid, callback, 0, w);
-  else if (callback != NULL)
-    rc += (*callback)(p->data);
-  tst_substring_traverse(p->hikid, callback, 0, w);
+  free(s);
 
   return !!rc;
 }
 
-/* ======================================================================== */
-/* Traverses the word tst looking for a wchar and build a list of pointers  */
-/* containing all the sub-tst nodes potentially leading to words containing */
-/* the next wchar os the search string.                                     */
-/* ======================================================================== */
+/* ============================================================ */
+/* Decodes the UTF-8 character at *s and moves *s just after it.*/
+/* ============================================================ */
+static wchar_t
+fuzzy_getc(const unsigned char **s)
+{
+  const unsigned char *p = *s;
+  int                  l = utf8_get_length(*p);
+  wchar_t              c;
+
+  c = l == 1 ? *p : *p & (0x3f >> (l - 1));
+  for (int i = 1; i < l; i++)
+    c = (c << 6) | (p[i] & 0x3f);
+
+  *s = p + l;
+
+  return c;
+}
+
+/* ====================================================================== */
+/* Builds the index used by the fuzzy search over the keys stored in the  */
+/* ternary search tree root.                                              */
+/* The keys are lowercased and, for each character present in them, a     */
+/* posting list of the keys containing it is built.                       */
+/* Returns NULL if the keys are too large to be indexed with 32-bit       */
+/* offsets.                                                               */
+/* ====================================================================== */
+fuzzy_index_t *
+fuzzy_index_new(tst_node_t *root)
+{
+  fuzzy_index_t       *fi;
+  size_t               text_len;
+  uint32_t            *counts; /* per character, then first slot in ids. */
+  uint32_t            *seen;   /* last key + 1 seen for each character.   */
+  uint32_t            *ids;    /* keys containing each character.        */
+  uint32_t             nb_ids   = 0;
+  uint32_t             nb_codes = 0; /* largest code point seen + 1.     */
+  long                *pos    = NULL;
+  const unsigned char *t;
+  wchar_t              c;
+
+  fi = xcalloc(1, sizeof(fuzzy_index_t));
+
+  if (!tst_flatten(root,
+                   1,
+                   &fi->text,
+                   &text_len,
+                   &fi->starts,
+                   &fi->data,
+                   &fi->nb_keys))
+  {
+    free(fi);
+
+    return NULL;
+  }
+
+  /* counts and seen only need to cover the code points up to the */
+  /* largest one present in the keys.                             */
+  /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+  for (uint32_t k = 0; k < fi->nb_keys; k++)
+  {
+    t = fi->text + fi->starts[k];
+    while (*t)
+    {
+      c = fuzzy_getc(&t);
+      if ((unsigned long)c < FUZZY_NB_CHARS && (uint32_t)c >= nb_codes)
+        nb_codes = c + 1;
+    }
+  }
+
+  counts = xcalloc(nb_codes + 1, sizeof(uint32_t));
+  seen   = xcalloc(nb_codes + 1, sizeof(uint32_t));
+
+  /* Count the keys containing each character, a character present  */
+  /* several times in a key is only counted once.                   */
+  /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+  for (uint32_t k = 0; k < fi->nb_keys; k++)
+  {
+    t = fi->text + fi->starts[k];
+    while (*t)
+    {
+      c = fuzzy_getc(&t);
+      if ((unsigned long)c < nb_codes && seen[c] != k + 1)
+      {
+        seen[c] = k + 1;
+        if (counts[c]++ == 0)
+          fi->nb_chars++;
+        nb_ids++;
+      }
+    }
+  }
+
+  fi->chars    = xmalloc((fi->nb_chars + 1) * sizeof(wchar_t));
+  fi->postings = xmalloc((fi->nb_chars + 1) * sizeof(posting_t *));
+
+  /* Turn counts into the first slot of each character in ids. */
+  /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+  for (uint32_t i = 0, total = 0, j = 0; i < nb_codes; i++)
+    if (counts[i] > 0)
+    {
+      fi->chars[j++] = i;
+      total += counts[i];
+      counts[i] = total - counts[i];
+    }
+
+  /* Fill ids, each run of keys is naturally sorted. */
+  /* """"""""""""""""""""""""""""""""""""""""""""""" */
+  ids = xmalloc((nb_ids + 1) * sizeof(uint32_t));
+  memset(seen, 0, nb_codes * sizeof(uint32_t));
+
+  for (uint32_t k = 0; k < fi->nb_keys; k++)
+  {
+    t = fi->text + fi->starts[k];
+    while (*t)
+    {
+      c = fuzzy_getc(&t);
+      if ((unsigned long)c < nb_codes && seen[c] != k + 1)
+      {
+        seen[c]         = k + 1;
+        ids[counts[c]++] = k;
+      }
+    }
+  }
+
+  /* Encode each run as a posting list, counts[c] is now the end of */
+  /* the run of c.                                                  */
+  /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+  if (nb_ids > 0)
+    pos = xmalloc(nb_ids * sizeof(long));
+
+  for (uint32_t j = 0, first = 0; j < fi->nb_chars; j++)
+  {
+    uint32_t last = counts[fi->chars[j]];
+
+    for (uint32_t i = first; i < last; i++)
+      pos[i - first] = ids[i];
+
+    fi->postings[j] = posting_new(pos, last - first);
+    first           = last;
+  }
+
+  free(pos);
+  free(ids);
+  free(seen);
+  free(counts);
+
+  return fi;
+}
+
+/* ====================================================================== */
+/* Searches the character c in the key k of the fuzzy index fi starting   */
+/* at the offset from.                                                    */
+/* Returns the offset just after the first occurrence found or 0 if c is  */
+/* not present.                                                           */
+/* ====================================================================== */
+static uint32_t
+fuzzy_index_find(fuzzy_index_t *fi, uint32_t from, const char *g, int l)
+{
+  const unsigned char *t = fi->text + from;
+  int                  i;
+
+  while (*t)
+  {
+    for (i = 0; i < l && t[i] == (unsigned char)g[i]; i++)
+      ;
+
+    if (i == l)
+      return t + l - fi->text;
+
+    t += utf8_get_length(*t);
+  }
+
+  return 0;
+}
+
+/* ====================================================================== */
+/* Narrows the fuzzy search candidates of level with the character w and  */
+/* stores the result in next. level is NULL when w is the first searched  */
+/* character.                                                             */
+/* A key remains a candidate if it contains w after the end of the        */
+/* leftmost match of the previous characters, this end is kept with each  */
+/* candidate so that the key is never rescanned from its beginning.       */
+/* The candidates which are not in the posting list of w are first        */
+/* discarded when this list is the shorter of the two.                    */
+/* Returns 1 if at least one candidate remains, 0 otherwise.              */
+/* ====================================================================== */
 int
-tst_fuzzy_traverse(tst_node_t *p,
-                   int (*callback)(void *),
-                   int     first_call,
-                   wchar_t w)
+fuzzy_index_search(fuzzy_index_t *fi,
+                   sub_tst_t     *level,
+                   sub_tst_t     *next,
+                   wchar_t        w)
 {
-  static int rc;
-  wchar_t    w1s[2];
-  wchar_t    w2s[2];
+  char           g[5];
+  int            l;
+  long           left, right, middle;
+  posting_t     *posting;
+  posting_iter_t it;
+  long           pos;
+  uint32_t       end;
 
-  w1s[1] = w2s[1] = L'\0';
+  next->nb_cands = 0;
 
-  if (first_call)
-    rc = 0;
+  w = wc_fold(w);
+  l = cptoutf8(g, w);
 
-  if (p == NULL)
+  /* Bisection search of the posting list of w. */
+  /* """""""""""""""""""""""""""""""""""""""""" */
+  left  = 0;
+  right = fi->nb_chars;
+  while (left < right)
+  {
+    middle = left + (right - left) / 2;
+    if (fi->chars[middle] < w)
+      left = middle + 1;
+    else
+      right = middle;
+  }
+
+  if (left == fi->nb_chars || fi->chars[left] != w)
     return 0;
 
-  w1s[0] = p->splitchar;
-  w2s[0] = w;
+  posting = fi->postings[left];
 
-  if (my_wcscasecmp(w1s, w2s) == 0)
+  free(next->cands);
+
+  if (level == NULL)
+  {
+    /* All the keys containing w are candidates. */
+    /* """"""""""""""""""""""""""""""""""""""""" */
+    next->cands = xmalloc(posting->count * sizeof(fuzzy_cand_t));
+
+    posting_iter_init(&it, posting);
+    while (posting_iter_next(&it, &pos))
+    {
+      next->cands[next->nb_cands].key = pos;
+      next->cands[next->nb_cands].end = fuzzy_index_find(fi,
+                                                         fi->starts[pos],
+                                                         g,
+                                                         l);
+      next->nb_cands++;
+    }
+  }
+  else if (posting->count < level->nb_cands)
   {
-    ll_node_t *node;
-    sub_tst_t *sub_tst_data;
+    /* Intersect the two sorted lists before checking the order. */
+    /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+    long i = 0;
+
+    next->cands = xmalloc(posting->count * sizeof(fuzzy_cand_t));
 
-    node         = tst_search_list->tail;
-    sub_tst_data = (sub_tst_t *)(node->data);
+    posting_iter_init(&it, posting);
+    while (i < level->nb_cands && posting_iter_next(&it, &pos))
+    {
+      while (i < level->nb_cands && level->cands[i].key < pos)
+        i++;
 
-    if (p->eqkid != NULL)
-      insert_sorted_ptr(&(sub_tst_data->array),
-                        &(sub_tst_data->size),
-                        &(sub_tst_data->count),
-                        p->eqkid);
+      if (i < level->nb_cands && level->cands[i].key == pos)
+      {
+        end = fuzzy_index_find(fi, level->cands[i].end, g, l);
+        if (end != 0)
+        {
+          next->cands[next->nb_cands].key = pos;
+          next->cands[next->nb_cands].end = end;
+          next->nb_cands++;
+        }
+        i++;
+      }
+    }
+  }
+  else
+  {
+    next->cands = xmalloc((level->nb_cands + 1) * sizeof(fuzzy_cand_t));
 
-    rc += 1;
+    for (long i = 0; i < level->nb_cands; i++)
+    {
+      end = fuzzy_index_find(fi, level->cands[i].end, g, l);
+      if (end != 0)
+      {
+        next->cands[next->nb_cands].key = level->cands[i].key;
+        next->cands[next->nb_cands].end = end;
+        next->nb_cands++;
+      }
+    }
   }
 
-  tst_fuzzy_traverse(p->lokid, callback, 0, w);
-  if (p->splitchar != L'\0')
-    tst_fuzzy_traverse(p->eqkid, callback, 0, w);
-  else if (callback != NULL)
-    rc += (*callback)(p->data);
-  tst_fuzzy_traverse(p->hikid, callback, 0, w);
+  return next->nb_cands > 0;
+}
+
+/* ====================================================================== */
+/* Applies the callback function to the data of each fuzzy search         */
+/* candidate of level.                                                    */
+/* Returns 1 if the callback function succeed (returned 1) at least once. */
+/* ====================================================================== */
+int
+fuzzy_index_traverse(fuzzy_index_t *fi,
+                     sub_tst_t     *level,
+                     int (*callback)(void *))
+{
+  int rc = 0;
+
+  for (long i = 0; i < level->nb_cands; i++)
+    rc += (*callback)(fi->data[level->cands[i].key]);
 
   return !!rc;
 }
 
+/* ======================================================== */
+/* Allocates and returns a newly created sub_tst_t element. */
+/* ======================================================== */
+sub_tst_t *
+sub_tst_new(void)
+{
+  sub_tst_t *elem = xmalloc(sizeof(sub_tst_t));
+
+  elem->size     = 64;
+  elem->count    = 0;
+  elem->array    = xmalloc(elem->size * sizeof(tst_node_t *));
+  elem->cands    = NULL;
+  elem->nb_cands = 0;
+
+  return elem;
+}
+
+/* ======================================================================= */
+/* Traverses the word tst looking for a wchar and build a list of pointers */
+/* containing all the sub-tst potentially leading to words containing the  */
+/* next wchar of the search string.                                        */
+/* ======================================================================= */
+int
+tst_substring_traverse(tst_node_t *p, int (*callback)(void *), wchar_t w)
+{
+  return tst_walk(p, callback, TST_WALK_SUBSTRING, w);
+}
+
+/* ======================================================================== */
+/* Traverses the word tst looking for a wchar and build a list of pointers  */
+/* containing all the sub-tst nodes potentially leading to words containing */
+/* the next wchar os the search string.                                     */
+/* ======================================================================== */
+int
+tst_fuzzy_traverse(tst_node_t *p, int (*callback)(void *), wchar_t w)
+{
+  return tst_walk(p, callback, TST_WALK_FUZZY, w);
+}
+
 /* ======================================================================= */
 /* Searches a complete string in a ternary tree starting from a root node. */
 /* ======================================================================= */
@@ -255,15 +1115,15 @@ tst_search(tst_node_t *root, wchar_t *w)
   while (p)
   {
     if (*w < p->splitchar)
-      p = p->lokid;
+      p = TST_CHILD(p->lokid);
     else if (*w == p->splitchar)
     {
       if (*w++ == L'\0')
         return p->data;
-      p = p->eqkid;
+      p = TST_CHILD(p->eqkid);
     }
     else
-      p = p->hikid;
+      p = TST_CHILD(p->hikid);
   }
 
   return NULL;
@@ -284,7 +1144,7 @@ tst_prefix_search(tst_node_t *root, wchar_t *w, int (*callback)(void *))
   while (p)
   {
     if (*w < p->splitchar)
-      p = p->lokid;
+      p = TST_CHILD(p->lokid);
     else if (*w == p->splitchar)
     {
       len--;
@@ -292,13 +1152,13 @@ tst_prefix_search(tst_node_t *root, wchar_t *w, int (*callback)(void *))
         return p->data;
       if (len == 0)
       {
-        rc = tst_traverse(p->eqkid, callback, 1);
+        rc = tst_traverse(TST_CHILD(p->eqkid), callback);
         return (void *)(long)rc;
       }
-      p = p->eqkid;
+      p = TST_CHILD(p->eqkid);
     }
     else
-      p = p->hikid;
+      p = TST_CHILD(p->hikid);
   }
 
   return NULL;
@@ -340,7 +1200,7 @@ tst_search_in_word(tst_node_t *root, wchar_t w)
       rc = 1;
       break;
     }
-    p = p->eqkid;
+    p = TST_CHILD(p->eqkid);
   }
 
   if (rc)
@@ -9,7 +9,8 @@
 #ifndef INDEX_H
 #define INDEX_H
 
-#include <stddef.h> /* for wchar_t */
+#include <stddef.h> /* for wchar_t  */
+#include <stdint.h> /* for uint32_t */
 
 /* *************************************** */
 /* Ternary Search Tree specific structures */
@@ -17,14 +18,25 @@
 
 typedef struct tst_node_s tst_node_t;
 typedef struct sub_tst_s  sub_tst_t;
+typedef struct tst_key_s  tst_key_t;
 
-#if 0 /* here for coherency but not used. */
-void tst_cleanup(tst_node_t * p);
-#endif
+typedef struct posting_s      posting_t;
+typedef struct posting_iter_s posting_iter_t;
+
+typedef struct sa_s sa_t;
+
+typedef struct fuzzy_index_s fuzzy_index_t;
+typedef struct fuzzy_cand_s  fuzzy_cand_t;
 
 tst_node_t *
 tst_insert(tst_node_t *p, wchar_t *w, void *data);
 
+void **
+tst_insert_or_get(tst_node_t **root, wchar_t *w);
+
+tst_node_t *
+tst_build(tst_node_t *p, tst_key_t *keys, long n);
+
 int
 my_wcscasecmp(const wchar_t *w1s, const wchar_t *w2s);
 
@@ -35,18 +47,13 @@ void *
 tst_search(tst_node_t *root, wchar_t *w);
 
 int
-tst_traverse(tst_node_t *p, int (*callback)(void *), int first_call);
+tst_traverse(tst_node_t *p, int (*callback)(void *));
 
 int
-tst_substring_traverse(tst_node_t *p,
-                       int (*callback)(void *),
-                       int     first_call,
-                       wchar_t w);
+tst_substring_traverse(tst_node_t *p, int (*callback)(void *), wchar_t w);
+
 int
-tst_fuzzy_traverse(tst_node_t *p,
-                   int (*callback)(void *),
-                   int     first_call,
-                   wchar_t w);
+tst_fuzzy_traverse(tst_node_t *p, int (*callback)(void *), wchar_t w);
 
 void *
 tst_search_in_word(tst_node_t *root, wchar_t w);
@@ -57,19 +64,81 @@ sub_tst_new(void);
 void
 append_tst_search_list(char *glyph, long l);
 
+sa_t *
+sa_new(tst_node_t *root);
+
+int
+sa_search(sa_t *sa, wchar_t *w, int (*callback)(void *));
+
+fuzzy_index_t *
+fuzzy_index_new(tst_node_t *root);
+
+int
+fuzzy_index_search(fuzzy_index_t *fi,
+                   sub_tst_t     *level,
+                   sub_tst_t     *next,
+                   wchar_t        w);
+
+int
+fuzzy_index_traverse(fuzzy_index_t *fi,
+                     sub_tst_t     *level,
+                     int (*callback)(void *));
+
+posting_t *
+posting_new(long *pos, long n);
+
+void
+posting_iter_init(posting_iter_t *it, posting_t *posting);
+
+int
+posting_iter_next(posting_iter_t *it, long *pos);
+
 void
 insert_sorted_ptr(tst_node_t ***array,
                   long         *size,
                   long         *filled,
                   tst_node_t   *ptr);
 
-/* Ternary node structure */
-/* """""""""""""""""""""" */
+/* Ternary node structure, the children are indexes in the node pool */
+/* of index.c, 0 meaning no child.                                   */
+/* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
 struct tst_node_s
 {
-  tst_node_t *lokid, *eqkid, *hikid;
-  void       *data;
-  wchar_t     splitchar;
+  uint32_t lokid, eqkid, hikid;
+  wchar_t  splitchar;
+  void    *data;
+};
+
+/* UTF-8 key and its payload, used to build a tst in one go. */
+/* """"""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+struct tst_key_s
+{
+  char *str;
+  long  pos;  /* position of the key in the input, used to sort the *
+               | identical keys.                                    */
+  void *data;
+};
+
+/* Sorted list of the positions of a word in the input.       */
+/* The first position is stored as is and the following ones  */
+/* as their distance to the previous one, encoded 7 bits per  */
+/* byte with the high bit set when more bytes follow.         */
+/* """""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+struct posting_s
+{
+  long          first;  /* first (smallest) position. */
+  long          count;  /* number of positions.       */
+  unsigned char gaps[]; /* the count-1 encoded gaps.  */
+};
+
+/* Cursor used to read the positions of a posting list in order. */
+/* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+struct posting_iter_s
+{
+  posting_t     *posting;
+  long           remaining; /* number of positions not yet read. */
+  long           pos;       /* last position read.               */
+  unsigned char *next;      /* next encoded gap.                 */
 };
 
 /* Structure to contain data and metadata attached to a fuzzy/substring. */
@@ -77,9 +146,53 @@ struct tst_node_s
 /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
 struct sub_tst_s
 {
-  tst_node_t **array;
-  long         size;
-  long         count;
+  tst_node_t  **array;
+  long          size;
+  long          count;
+  fuzzy_cand_t *cands;    /* candidates when the fuzzy index is used. */
+  long          nb_cands;
+};
+
+/* Suffix array over the keys of a ternary search tree, used by the */
+/* substring search.                                                */
+/* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+struct sa_s
+{
+  unsigned char *text;        /* UTF-8 keys, each followed by a '\0'.    */
+  uint32_t      *suffixes;    /* offsets in text of the sorted suffixes. */
+  uint32_t       nb_suffixes;
+  uint32_t      *starts;      /* offset in text of each key.             */
+  void         **data;        /* data attached to each key.              */
+  uint32_t       nb_keys;
+  uint32_t      *stamps;      /* last search which reported each key.    */
+  uint32_t       stamp;       /* current search.                         */
+};
+
+/* Index used by the fuzzy search: the lowercased keys of a ternary    */
+/* search tree and the sorted list of the keys containing each of the  */
+/* characters present in them.                                         */
+/* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+#define FUZZY_NB_CHARS 0x110000 /* number of Unicode code points. */
+
+struct fuzzy_index_s
+{
+  unsigned char *text;     /* lowercased UTF-8 keys, each followed by a  *
+                            | '\0'.                                      */
+  uint32_t      *starts;   /* offset in text of each key.                */
+  void         **data;     /* data attached to each key.                 */
+  uint32_t       nb_keys;
+  wchar_t       *chars;    /* sorted characters present in the keys.     */
+  posting_t    **postings; /* keys containing each of these characters. */
+  uint32_t       nb_chars;
+};
+
+/* Fuzzy search candidate: a key containing the searched characters in   */
+/* order and the offset just after the leftmost occurrence of them.      */
+/* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+struct fuzzy_cand_s
+{
+  uint32_t key;
+  uint32_t end;
 };
 
 #endif
@@ -55,7 +55,8 @@ extern ll_t *tst_search_list;
 /* Global variables. */
 /* ***************** */
 
-word_t *word_a;       /* array containing words data (size: count).        */
+word_t      *word_a;      /* array containing words data (size: count).    */
+word_cold_t *word_cold_a; /* remaining words data (size: count).           */
 long    count = 0;    /* number of words read from stdin.                  */
 long    current;      /* index the current selection under the cursor).    */
 long    new_current;  /* final cur. position, (used in search function).   */
@@ -69,6 +70,10 @@ long *shift_right_sym_pos_a; /* screen column number of the right          *
                               | scrolling symbol if any when in line or    *
                               | column mode.                               */
 
+arena_t *word_arena; /* storage of the word strings and bitmaps.         */
+
+FILE *progress_tty = NULL; /* where to show the reading progress.        */
+
 int forgotten_timer = -1;
 int help_timer      = -1;
 int winch_timer     = -1;
@@ -138,6 +143,35 @@ long *alt_matching_words_da = NULL; /* Alternate array to contain only *
                                      | potentially a starting/ending   *
                                      | pattern.                        */
 
+char *matching_words_bits = NULL; /* Bit array indexed by the word *
+                                   | indexes where the matching    *
+                                   | words are collected before    *
+                                   | being sorted in               *
+                                   | matching_words_da.            */
+
+long **matching_words_stack_da = NULL; /* matching_words_da of each of *
+                                        | the shorter search strings,  *
+                                        | the last one is the longest. */
+
+/* Search data saved by update_bitmaps to compute the bitmaps of the */
+/* matching words when they are displayed.                           */
+/* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+search_mode_t     bitmaps_mode = NONE; /* NONE when no bitmap is set. */
+bitmap_affinity_t bitmaps_affinity;
+search_data_t     bitmaps_data;       /* copy of the search data.       */
+unsigned          bitmaps_gen = 1;    /* bitmaps computed before the    *
+                                       | last change are outdated.      */
+
+/* Variables used to rank the fuzzy matches. */
+/* """"""""""""""""""""""""""""""""""""""""" */
+ranked_word_t *ranked_words_da = NULL; /* heap then sorted array of the  *
+                                        | best scored fuzzy matches.     */
+long          *score_buf       = NULL; /* work area of fuzzy_score.      */
+long           score_buf_size  = 0;
+long           score_max;              /* highest possible scores, see   *
+                                        | set_score_bounds.              */
+long           score_max_lower;
+
 /* Variables used in signal handlers. */
 /* """""""""""""""""""""""""""""""""" */
 volatile sig_atomic_t got_winch          = 0;
@@ -1394,9 +1428,64 @@ tag_swap(void **a, void **b)
 /* Utility function to zero the bitmap field in a word. */
 /* ==================================================== */
 void
-clear_bitmap(word_t *word)
+clear_bitmap(long n)
+{
+  memset(word_cold_a[n].bitmap,
+         '\0',
+         (word_a[n].mb - daccess.flength) / CHAR_BIT + 1);
+}
+
+/* ================================================================== */
+/* Returns the case folded version of str used by the fuzzy search    */
+/* without its trailing blanks. str itself is returned when it is     */
+/* already folded, otherwise the folded copy is stored in word_arena. */
+/* ================================================================== */
+char *
+fold_word(char *str)
+{
+  char *fold;
+
+  fold = xmalloc(2 * strlen(str) + 1);
+  utf8_strfold(fold, str);
+  rtrim(fold, " \t", 0);
+
+  if (strcmp(fold, str) == 0)
+  {
+    free(fold);
+    return str;
+  }
+
+  str = arena_strdup(word_arena, fold);
+  free(fold);
+
+  return str;
+}
+
+/* ==================================================================== */
+/* Returns the number of screen positions taken by the UTF-8 string str */
+/* and sets *nb_glyphs to its number of glyphs. Strings only made of    */
+/* printable ASCII characters, the most common case, do not need to be  */
+/* converted in wide characters for that.                               */
+/* ==================================================================== */
+long
+get_str_width(char *str, long *nb_glyphs)
 {
-  memset(word->bitmap, '\0', (word->mb - daccess.flength) / CHAR_BIT + 1);
+  size_t   len = strlen(str);
+  wchar_t *w;
+  long     width;
+
+  if (isprint7_str(str, len))
+  {
+    *nb_glyphs = (long)len;
+
+    return (long)len;
+  }
+
+  *nb_glyphs = (long)mbstowcs(NULL, str, 0);
+  width      = my_wcswidth((w = utf8_strtowcs(str)), *nb_glyphs);
+  free(w);
+
+  return width;
 }
 
 /* ========================================= */
@@ -1438,7 +1527,7 @@ my_beep(toggle_t *toggles)
 /* alignment IN     kind of alignments.                           */
 /* ============================================================== */
 void
-align_word(word_t *word, alignment_t alignment, size_t prefix, char sp)
+align_word(word_cold_t *word, alignment_t alignment, size_t prefix, char sp)
 {
   switch (alignment)
   {
@@ -1535,284 +1624,684 @@ check_integer_constraint(int nb_args, char **args, char *value, char *par)
 }
 
 /* ======================================================================= */
-/* Update the bitmap associated with a word. The bits set to 1 in this     */
-/* bitmap indicate the positions of the UFT-8 glyphs of the search buffer  */
-/* in the word.                                                            */
-/*                                                                         */
-/* The disp_word function will use it to display these special characters. */
-/*                                                                         */
-/* mode     is the search method.                                          */
-/* data     contains information about the search buffer.                  */
-/* affinity determines if we must only consider matches that occur at      */
-/*          the start, the end or if we just don't care.                   */
+/* Computes in bm the bitmap of the word n from the search data saved by   */
+/* update_bitmaps. The bits set to 1 in this bitmap indicate the positions */
+/* of the UFT-8 glyphs of the search buffer in the word.                   */
 /* ======================================================================= */
 void
-update_bitmaps(search_mode_t     mode,
-               search_data_t    *data,
-               bitmap_affinity_t affinity)
+build_bitmap(long n, char *bm)
 {
-  long i, j, n; /* work variables.                                       */
+  long j; /* work variable.                                              */
 
   long bm_len; /* number of chars taken by the bit mask.                 */
 
   char *start; /* pointer on the position of the matching position       *
                 | of the last search buffer glyph in the word.           */
 
-  char *bm; /* the word's current bitmap.                                */
+  char *str; /* the word, case folded in fuzzy search mode.             */
+  char *end; /* end of str without its trailing blanks.                  */
 
-  char *str;      /* copy of the current word put in lower case.         */
-  char *str_orig; /* original version of the word.                       */
+  char *sb = bitmaps_data.buf; /* sb: search buffer.                     */
 
-  char *sb_orig = data->buf; /* sb: search buffer.                       */
+  long *o    = bitmaps_data.off_a;      /* array of the offsets of the   *
+                                         | search buffer glyphs.         */
+  long *l    = bitmaps_data.len_a;      /* array of the lengths in bytes *
+                                         | of the search buffer glyphs.  */
+  long  last = bitmaps_data.mb_len - 1; /* offset of the last glyph in   *
+                                         | the search buffer.            */
 
-  long *o    = data->off_a;      /* array of the offsets of the search   *
-                                  | buffer glyphs.                       */
-  long *l    = data->len_a;      /* array of the lengths in bytes of     *
-                                  | the search buffer glyphs.            */
-  long  last = data->mb_len - 1; /* offset of the last glyph in the      *
-                                  | search buffer.                       */
+  long lmg;         /* Position of the last matching glyph of the search *
+                     | buffer in a word.                                 */
 
-  BUF_CLEAR(best_matching_words_da);
+  bm_len = (word_a[n].mb - daccess.flength) / CHAR_BIT + 1;
 
-  if (mode == FUZZY || mode == SUBSTRING)
+  if (bitmaps_mode == PREFIX)
   {
-    char *sb;
-    char *first_glyph;
-    long  badness = 0; /* number of 0s between two 1s. */
+    memset(bm, '\0', bm_len);
 
-    first_glyph = xmalloc(5);
+    for (j = 0; j <= last; j++)
+      BIT_ON(bm, j + word_cold_a[n].offset);
 
-    /* In fuzzy search mode, case is not taken into account */
-    /* during the search.                                   */
-    /* """""""""""""""""""""""""""""""""""""""""""""""""""" */
-    if (mode == FUZZY)
-    {
-      sb = xstrdup(sb_orig); /* sb initially points to sb_orig. */
-      utf8_strtolower(sb, sb_orig);
-    }
-    else
-      sb = sb_orig;
+    return;
+  }
 
-    for (i = 0; i < (long)BUF_LEN(matching_words_da); i++)
-    {
-      long lmg; /* Position of the last matching glyph of the search buffer *
-                 | in a word.                                               */
+  /* In fuzzy search mode the case folded version of the word computed */
+  /* once for all is used for comparison reason.                       */
+  /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+  if (bitmaps_mode == FUZZY)
+    str = word_cold_a[n].fold;
+  else
+    str = word_cold_a[n].str + daccess.flength + word_cold_a[n].offset;
 
-      n = matching_words_da[i];
+  /* The trailing spaces must be ignored by the following algorithm. */
+  /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+  end = str + strlen(str);
+  while (end > str && (end[-1] == ' ' || end[-1] == '\t'))
+    end--;
 
-      str_orig = xstrdup(word_a[n].str + daccess.flength + word_a[n].offset);
+  start = str;
+  lmg   = 0;
 
-      /* We need to remove the trailing spaces to use the     */
-      /* following algorithm.                                 */
-      /* .len holds the original length in bytes of the word. */
-      /* """""""""""""""""""""""""""""""""""""""""""""""""""" */
-      rtrim(str_orig, " \t", 0);
+  /* Start points to the first UTF-8 glyph of the word. */
+  /* """""""""""""""""""""""""""""""""""""""""""""""""" */
+  while (start != NULL && start < end)
+  {
+    /* Reset the bitmap. */
+    /* """"""""""""""""" */
+    memset(bm, '\0', bm_len);
 
-      bm_len = (word_a[n].mb - daccess.flength) / CHAR_BIT + 1;
-      bm     = word_a[n].bitmap;
+    /* Compare the glyph pointed to by start to the last glyph of */
+    /* the search buffer, the aim is to point to the first        */
+    /* occurrence of the last glyph of it.                        */
+    /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+    if (memcmp(start, sb + o[last], l[last]) == 0)
+    {
+      char *p; /* Pointer to the beginning of an UTF-8 glyph in *
+                | the potential lowercase version of the word.  */
 
-      /* In fuzzy search mode str are converted in lower case letters */
-      /* for comparison reason.                                       */
-      /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
-      if (mode == FUZZY)
+      long sg; /* Index going from lmg backward to 0 of the tested *
+                | glyphs of the search buffer (searched glyph).    */
+
+      if (last == 0)
       {
-        str = xstrdup(str_orig);
-        utf8_strtolower(str, str_orig);
+        /* There is only one glyph in the search buffer, we can */
+        /* stop here.                                           */
+        /* """""""""""""""""""""""""""""""""""""""""""""""""""" */
+        BIT_ON(bm, lmg + word_cold_a[n].offset);
+        if (bitmaps_affinity != END_AFFINITY)
+          break;
       }
-      else
-        str = str_orig;
 
-      start = str;
-      lmg   = 0;
+      /* If the search buffer contains more than one glyph, we need  */
+      /* to search the first combination which match the buffer in   */
+      /* the word.                                                   */
+      /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+      p = start;
+      j = last; /* j counts the number of glyphs in the search buffer *
+                 | not found in the word.                             */
+
+      /* Proceed backwards from the position of last glyph of the      */
+      /* search to check if all the previous glyphs can be fond before */
+      /* in the word. If not try to find the next position of this     */
+      /* last glyph in the word.                                       */
+      /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+      sg = lmg;
+      while (j > 0 && (p = utf8_prev(str, p)) != NULL)
+      {
+        if (memcmp(p, sb + o[j - 1], l[j - 1]) == 0)
+        {
+          BIT_ON(bm, sg - 1 + word_cold_a[n].offset);
+          j--;
+        }
+        else if (bitmaps_mode == SUBSTRING)
+          break;
+
+        sg--;
+      }
 
-      /* Start points to the first UTF-8 glyph of the word. */
-      /* """""""""""""""""""""""""""""""""""""""""""""""""" */
-      while ((size_t)(start - str) < word_a[n].len - daccess.flength)
+      /* All the glyphs have been found. */
+      /* """"""""""""""""""""""""""""""" */
+      if (j == 0)
       {
-        /* Reset the bitmap. */
-        /* """"""""""""""""" */
-        memset(bm, '\0', bm_len);
+        BIT_ON(bm, lmg + word_cold_a[n].offset);
+        if (bitmaps_affinity != END_AFFINITY)
+          break;
+      }
+    }
 
-        /* Compare the glyph pointed to by start to the last glyph of */
-        /* the search buffer, the aim is to point to the first        */
-        /* occurrence of the last glyph of it.                        */
-        /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
-        if (memcmp(start, sb + o[last], l[last]) == 0)
-        {
-          char *p; /* Pointer to the beginning of an UTF-8 glyph in *
-                    | the potential lowercase version of the word.  */
+    lmg++;
+    start = utf8_next(start);
+  }
 
-          long sg; /* Index going from lmg backward to 0 of the tested *
-                    | glyphs of the search buffer (searched glyph).    */
+  if (bitmaps_mode == FUZZY)
+  {
+    /* We know that the first non blank glyph is part of the pattern, */
+    /* so highlight it if it is not and suppresses the highlighting   */
+    /* of the next occurrence that must be here because this word has */
+    /* already been filtered by select_starting_pattern().            */
+    /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+    if (bitmaps_affinity == START_AFFINITY)
+    {
+      long i;
+      long mb_len;
+      char first_glyph[5];
 
-          if (last == 0)
-          {
-            /* There is only one glyph in the search buffer, we can */
-            /* stop here.                                           */
-            /* """""""""""""""""""""""""""""""""""""""""""""""""""" */
-            BIT_ON(bm, lmg + word_a[n].offset);
-            if (affinity != END_AFFINITY)
-              break;
-          }
+      /* Skip leading spaces and tabs. */
+      /* """"""""""""""""""""""""""""" */
+      for (i = 0; i < word_a[n].mb; i++)
+        if (!isblank(*(word_cold_a[n].str + daccess.flength
+                       + word_cold_a[n].offset + i)))
+          break;
 
-          /* If the search buffer contains more than one glyph, we need  */
-          /* to search the first combination which match the buffer in   */
-          /* the word.                                                   */
-          /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
-          p = start;
-          j = last; /* j counts the number of glyphs in the search buffer *
-                     | not found in the word.                             */
-
-          /* Proceed backwards from the position of last glyph of the      */
-          /* search to check if all the previous glyphs can be fond before */
-          /* in the word. If not try to find the next position of this     */
-          /* last glyph in the word.                                       */
-          /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
-          sg = lmg;
-          while (j > 0 && (p = utf8_prev(str, p)) != NULL)
-          {
-            if (memcmp(p, sb + o[j - 1], l[j - 1]) == 0)
-            {
-              BIT_ON(bm, sg - 1 + word_a[n].offset);
-              j--;
-            }
-            else if (mode == SUBSTRING)
-              break;
+      utf8_strprefix(first_glyph, word_cold_a[n].str + i, 1, &mb_len);
 
-            sg--;
-          }
+      if (!BIT_ISSET(bm, i + word_cold_a[n].offset))
+      {
+        char *ptr1, *ptr2;
 
-          /* All the glyphs have been found. */
-          /* """"""""""""""""""""""""""""""" */
-          if (j == 0)
+        BIT_ON(bm, i + word_cold_a[n].offset);
+
+        ptr1 = word_cold_a[n].str + i;
+        i++;
+        while ((ptr2 = utf8_next(ptr1)) != NULL)
+        {
+          if (memcmp(ptr2, first_glyph, mb_len) == 0)
           {
-            BIT_ON(bm, lmg + word_a[n].offset);
-            if (affinity != END_AFFINITY)
+            if (BIT_ISSET(bm, i + word_cold_a[n].offset))
+            {
+              BIT_OFF(bm, i + word_cold_a[n].offset);
               break;
+            }
+            else
+              ptr1 = ptr2;
           }
-        }
+          else
+            ptr1 = ptr2;
 
-        lmg++;
-        start = utf8_next(start);
+          i++;
+        }
       }
+    }
+  }
+}
 
-      if (mode == FUZZY)
-      {
-        size_t mb_index;
+/* ===================================================================== */
+/* Returns 1 if the case folded search buffer appears without holes in   */
+/* the case folded version of the word n, at its start or end if the     */
+/* affinity requires it, and 0 otherwise. The bitmap of the word is not  */
+/* needed for that.                                                      */
+/* ===================================================================== */
+int
+is_contiguous_match(long n)
+{
+  char  *str = word_cold_a[n].fold; /* has no trailing blanks. */
+  char  *sb  = bitmaps_data.buf;
+  size_t len = bitmaps_data.len;
+  size_t wlen;
+  char  *p;
 
-        free(str);
+  switch (bitmaps_affinity)
+  {
+    case START_AFFINITY:
+      for (p = str; isblank((unsigned char)*p); p++)
+        ;
+      return strncmp(p, sb, len) == 0;
 
-        /* We know that the first non blank glyph is part of the pattern, */
-        /* so highlight it if it is not and suppresses the highlighting   */
-        /* of the next occurrence that must be here because this word has */
-        /* already been filtered by select_starting_pattern().            */
-        /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
-        if (affinity == START_AFFINITY)
-        {
-          size_t i;
-          long   mb_len;
-
-          /* Skip leading spaces and tabs. */
-          /* """"""""""""""""""""""""""""" */
-          for (i = 0; i < word_a[n].mb; i++)
-            if (!isblank(
-                  *(word_a[n].str + daccess.flength + word_a[n].offset + i)))
-              break;
+    case END_AFFINITY:
+      wlen = strlen(str);
+      return wlen >= len && memcmp(str + wlen - len, sb, len) == 0;
 
-          first_glyph = utf8_strprefix(first_glyph,
-                                       word_a[n].str + i,
-                                       1,
-                                       &mb_len);
+    default:
+      return strstr(str, sb) != NULL;
+  }
+}
 
-          if (!BIT_ISSET(word_a[n].bitmap, i + word_a[n].offset))
-          {
-            char *ptr1, *ptr2;
+/* ======================================================================= */
+/* Saves the search data used to compute the bitmaps associated with the   */
+/* matching words. These bitmaps are only computed when a word is          */
+/* displayed, see word_bitmap.                                             */
+/*                                                                         */
+/* The disp_word function will use it to display these special characters. */
+/*                                                                         */
+/* mode     is the search method.                                          */
+/* data     contains information about the search buffer.                  */
+/* affinity determines if we must only consider matches that occur at      */
+/*          the start, the end or if we just don't care.                   */
+/*                                                                         */
+/* In fuzzy search mode, the words whose matched glyphs are consecutive    */
+/* are also collected in best_matching_words_da and the best scored ones   */
+/* in ranked_words_da.                                                     */
+/* ======================================================================= */
+void
+update_bitmaps(search_mode_t     mode,
+               search_data_t    *data,
+               bitmap_affinity_t affinity)
+{
+  bitmaps_mode     = mode;
+  bitmaps_affinity = affinity;
 
-            BIT_ON(word_a[n].bitmap, i + word_a[n].offset);
+  /* Take a copy of the search buffer as it may change before the */
+  /* bitmaps are computed.                                        */
+  /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+  free(bitmaps_data.buf);
+  bitmaps_data.mb_len = data->mb_len;
+  bitmaps_data.off_a  = xrealloc(bitmaps_data.off_a,
+                                (data->mb_len + 1) * sizeof(long));
+  bitmaps_data.len_a  = xrealloc(bitmaps_data.len_a,
+                                (data->mb_len + 1) * sizeof(long));
+
+  /* In fuzzy search mode, case is not taken into account during */
+  /* the search. The length of the glyphs may change when they   */
+  /* are case folded.                                            */
+  /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+  if (mode == FUZZY)
+  {
+    char *p;
 
-            ptr1 = word_a[n].str + i;
-            i++;
-            while ((ptr2 = utf8_next(ptr1)) != NULL)
-            {
-              if (memcmp(ptr2, first_glyph, mb_len) == 0)
-              {
-                if (BIT_ISSET(word_a[n].bitmap, i + word_a[n].offset))
-                {
-                  BIT_OFF(word_a[n].bitmap, i + word_a[n].offset);
-                  break;
-                }
-                else
-                  ptr1 = ptr2;
-              }
-              else
-                ptr1 = ptr2;
+    bitmaps_data.buf = xmalloc(2 * data->len + 1);
+    bitmaps_data.len = utf8_strfold(bitmaps_data.buf, data->buf);
 
-              i++;
-            }
-          }
-        }
+    p = bitmaps_data.buf;
+    for (long i = 0; i < data->mb_len; i++)
+    {
+      bitmaps_data.off_a[i] = p - bitmaps_data.buf;
+      bitmaps_data.len_a[i] = utf8_get_length(*p);
+      p += bitmaps_data.len_a[i];
+    }
+  }
+  else
+  {
+    bitmaps_data.buf = xstrdup(data->buf);
+    bitmaps_data.len = data->len;
+    memcpy(bitmaps_data.off_a, data->off_a, data->mb_len * sizeof(long));
+    memcpy(bitmaps_data.len_a, data->len_a, data->mb_len * sizeof(long));
+  }
 
-        /* Compute the number of 'holes' in the bitmap to determine the  */
-        /* badness of a match. The goal is to put the cursor on the word */
-        /* with the smallest badness.                                    */
-        /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
-        mb_index = 0;
-        j        = 0;
-        badness  = 0;
+  /* Invalidate all the bitmaps already computed. */
+  /* """""""""""""""""""""""""""""""""""""""""""" */
+  bitmaps_gen++;
 
-        while (mb_index < word_a[n].mb
-               && !BIT_ISSET(word_a[n].bitmap, mb_index + word_a[n].offset))
-          mb_index++;
+  BUF_CLEAR(best_matching_words_da);
+  BUF_CLEAR(ranked_words_da);
 
-        while (mb_index < word_a[n].mb)
-        {
-          if (!BIT_ISSET(word_a[n].bitmap, mb_index + word_a[n].offset))
-            badness++;
-          else
-            j++;
+  /* In fuzzy search mode, the words matching without holes and the */
+  /* scores are found from the folded words, the bitmaps are still   */
+  /* only built when the words are displayed.                        */
+  /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+  if (mode == FUZZY && search_mode == FUZZY)
+  {
+    set_score_bounds();
 
-          /* Stop here if all the possible bits has been checked as they  */
-          /* cannot be more numerous than the number of UTF-8 glyphs in   */
-          /* the search buffer.                                           */
-          /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
-          if (j == data->mb_len)
-            break;
+    for (long i = 0; i < (long)BUF_LEN(matching_words_da); i++)
+    {
+      long n = matching_words_da[i];
 
-          mb_index++;
-        }
+      /* Add the position of the best matches at the end of a special */
+      /* array which will be used to move the cursor among this       */
+      /* category of words.                                           */
+      /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+      if (is_contiguous_match(n))
+        BUF_PUSH(best_matching_words_da, n);
+
+      /* Once the heap of the best ranked words is full, the words which */
+      /* cannot score more than its worst one are not scored at all: at  */
+      /* equal score, a later word is ranked worse.                      */
+      /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+      if (BUF_LEN(ranked_words_da) == RANKED_WORDS_NB)
+      {
+        char *word = word_cold_a[n].str + daccess.flength
+                     + word_cold_a[n].offset;
+        long  max  = word_cold_a[n].fold == word ? score_max_lower : score_max;
+
+        if (ranked_words_da[0].score >= max)
+          continue;
       }
-      free(str_orig);
 
-      if (search_mode == FUZZY)
+      rank_word(n, fuzzy_score(n));
+    }
+
+    sort_ranked_words();
+  }
+}
+
+/* ====================================================================== */
+/* Forgets the search data saved by update_bitmaps, all the bitmaps will  */
+/* be seen empty until its next call.                                     */
+/* ====================================================================== */
+void
+invalidate_bitmaps(void)
+{
+  bitmaps_mode = NONE;
+  bitmaps_gen++;
+}
+
+/* ====================================================================== */
+/* Returns the bitmap of the word n, computing it first if it has not     */
+/* been since the last call to update_bitmaps. Only the words present in  */
+/* matching_words_da can have bits set in their bitmaps.                  */
+/* ====================================================================== */
+char *
+word_bitmap(long n)
+{
+  long left, right, middle;
+
+  if (word_cold_a[n].bitmap_gen == bitmaps_gen)
+    return word_cold_a[n].bitmap;
+
+  word_cold_a[n].bitmap_gen = bitmaps_gen;
+
+  clear_bitmap(n);
+
+  if (bitmaps_mode == NONE)
+    return word_cold_a[n].bitmap;
+
+  /* Bisection search of n in matching_words_da. */
+  /* """"""""""""""""""""""""""""""""""""""""""" */
+  left  = 0;
+  right = BUF_LEN(matching_words_da);
+  while (left < right)
+  {
+    middle = left + (right - left) / 2;
+    if (matching_words_da[middle] < n)
+      left = middle + 1;
+    else
+      right = middle;
+  }
+
+  if (left < (long)BUF_LEN(matching_words_da)
+      && matching_words_da[left] == n)
+    build_bitmap(n, word_cold_a[n].bitmap);
+
+  return word_cold_a[n].bitmap;
+}
+
+/* ====================================================================== */
+/* Scores the fuzzy match of the search buffer saved by update_bitmaps in */
+/* the word n, the higher the better.                                     */
+/* Each matched glyph is worth SCORE_MATCH plus SCORE_CONSECUTIVE if it   */
+/* follows the previous matched one and SCORE_BOUNDARY if it starts a     */
+/* part of the word (twice for the first glyph of the search buffer).     */
+/* SCORE_GAP_START and SCORE_GAP are subtracted for the first and the     */
+/* next glyphs skipped between two matched ones.                          */
+/*                                                                        */
+/* The best placement of the search buffer is found by dynamic            */
+/* programming, when it would need more than SCORE_MAX_CELLS cells the    */
+/* leftmost placement is scored instead.                                  */
+/* ====================================================================== */
+long
+fuzzy_score(long n)
+{
+  char *str  = word_cold_a[n].fold;
+  char *orig = word_cold_a[n].str + daccess.flength + word_cold_a[n].offset;
+  char *sb   = bitmaps_data.buf;
+  long *o    = bitmaps_data.off_a;
+  long *l    = bitmaps_data.len_a;
+  long  m    = bitmaps_data.mb_len;
+
+  long  nb; /* number of glyphs in str.                                 */
+  long *off, *len, *bonus;
+  long *mp, *gp, *mc, *gc, *tmp;
+  long  i, j;
+  long  score;
+  char *p, *q, *r;
+
+  /* The number of bytes of str bounds its number of glyphs. */
+  /* """"""""""""""""""""""""""""""""""""""""""""""""""""""" */
+  nb = strlen(str);
+
+  if (nb == 0 || m == 0)
+    return 0;
+
+  if (7 * nb > score_buf_size)
+  {
+    score_buf_size = 7 * nb;
+    score_buf      = xrealloc(score_buf, score_buf_size * sizeof(long));
+  }
+
+  off   = score_buf;
+  len   = off + nb;
+  bonus = len + nb;
+  mp    = bonus + nb;
+  gp    = mp + nb;
+  mc    = gp + nb;
+  gc    = mc + nb;
+
+  /* Locate the glyphs of str and give a bonus to the ones starting */
+  /* the word, following a separator or an ASCII lower case letter  */
+  /* if they are ASCII upper case letters in the original word.     */
+  /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+  p = str;
+  q = orig;
+  r = orig;
+  for (j = 0; *p != '\0'; j++)
+  {
+    off[j] = p - str;
+
+    if (j == 0)
+      bonus[j] = SCORE_BOUNDARY;
+    else
+    {
+      unsigned char c  = str[off[j - 1]]; /* previous folded glyph.   */
+      unsigned char oc = *r;              /* previous original glyph. */
+
+      if (c < 0x80 && !isalnum(c))
+        bonus[j] = SCORE_BOUNDARY;
+      else if (oc < 0x80 && islower(oc) && isupper((unsigned char)*q))
+        bonus[j] = SCORE_BOUNDARY;
+      else
+        bonus[j] = 0;
+    }
+
+    for (p++; (*p & 0xc0) == 0x80; p++)
+      ;
+    len[j] = p - str - off[j];
+
+    r = q;
+    for (q++; (*q & 0xc0) == 0x80; q++)
+      ;
+  }
+  nb = j;
+
+  /* The word is too long to be scored by dynamic programming, score */
+  /* the leftmost placement of the search buffer in it.              */
+  /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+  if (m * nb > SCORE_MAX_CELLS)
+  {
+    long last = -1;
+
+    score = 0;
+    i     = 0;
+    for (j = 0; j < nb && i < m; j++)
+    {
+      if (str[off[j]] != sb[o[i]] || len[j] != l[i]
+          || memcmp(str + off[j], sb + o[i], l[i]) != 0)
+        continue;
+
+      i++;
+
+      score += SCORE_MATCH + bonus[j];
+
+      if (last < 0)
+        score += bonus[j];
+      else if (last == j - 1)
+        score += SCORE_CONSECUTIVE;
+      else
+        score -= SCORE_GAP_START + SCORE_GAP * (j - last - 2);
+
+      last = j;
+    }
+
+    return score;
+  }
+
+  /* mc[j]: best score of the first glyphs of the search buffer up to */
+  /*        the current one, the latter being matched on the glyph j. */
+  /* gc[j]: same but the last one being matched before the glyph j,   */
+  /*        the skipped glyphs being penalized.                       */
+  /* mp and gp hold the same values for the previous glyph of the     */
+  /* search buffer.                                                   */
+  /* The glyph i of the search buffer can only be matched between the */
+  /* glyphs i and nb - m + i of str, the other cells are not needed.  */
+  /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+  score = SCORE_NONE;
+
+  for (i = 0; i < m; i++)
+  {
+    long pm = SCORE_NONE; /* mc[j - 1]. */
+    long pg = SCORE_NONE; /* gc[j - 1]. */
+
+    for (j = i; j <= nb - m + i; j++)
+    {
+      if (str[off[j]] != sb[o[i]] || len[j] != l[i]
+          || memcmp(str + off[j], sb + o[i], l[i]) != 0)
+        mc[j] = SCORE_NONE;
+      else if (i == 0)
+        mc[j] = SCORE_MATCH + 2 * bonus[j];
+      else
       {
-        /* When the badness is zero (best match), add the word position. */
-        /* at the end of a special array which will be used to move the. */
-        /* cursor among this category of words.                          */
-        /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
-        if (badness == 0)
-          BUF_PUSH(best_matching_words_da, n);
+        long best = gp[j - 1];
+
+        if (mp[j - 1] != SCORE_NONE && mp[j - 1] + SCORE_CONSECUTIVE > best)
+          best = mp[j - 1] + SCORE_CONSECUTIVE;
+
+        mc[j] = best == SCORE_NONE ? SCORE_NONE
+                                   : best + SCORE_MATCH + bonus[j];
       }
+
+      gc[j] = pm == SCORE_NONE ? SCORE_NONE : pm - SCORE_GAP_START;
+
+      if (pg != SCORE_NONE && pg - SCORE_GAP > gc[j])
+        gc[j] = pg - SCORE_GAP;
+
+      pm = mc[j];
+      pg = gc[j];
+
+      if (i == m - 1 && mc[j] > score)
+        score = mc[j];
     }
 
-    if (mode == FUZZY)
-      free(sb);
+    tmp = mp;
+    mp  = mc;
+    mc  = tmp;
+    tmp = gp;
+    gp  = gc;
+    gc  = tmp;
+  }
 
-    free(first_glyph);
+  return score;
+}
+
+/* ====================================================================== */
+/* Sets score_max to the highest score fuzzy_score can give to a word for */
+/* the search buffer saved by update_bitmaps and score_max_lower to the   */
+/* highest one for a word left unchanged by case folding.                 */
+/* A glyph following the previous matched one can only start a part of   */
+/* the word after an ASCII symbol or at a lower to upper case transition, */
+/* which such a word does not contain. A glyph matched after a gap cannot */
+/* do better as SCORE_GAP_START is not less than SCORE_BOUNDARY minus     */
+/* SCORE_CONSECUTIVE.                                                     */
+/* ====================================================================== */
+void
+set_score_bounds(void)
+{
+  char *sb = bitmaps_data.buf;
+  long *o  = bitmaps_data.off_a;
+  long  m  = bitmaps_data.mb_len;
+
+  if (m == 0)
+  {
+    score_max       = 0;
+    score_max_lower = 0;
+    return;
   }
-  else if (mode == PREFIX)
+
+  score_max       = SCORE_MATCH + 2 * SCORE_BOUNDARY;
+  score_max_lower = score_max;
+
+  for (long i = 1; i < m; i++)
   {
-    for (i = 0; i < (long)BUF_LEN(matching_words_da); i++)
+    unsigned char c = sb[o[i - 1]];
+
+    score_max += SCORE_MATCH + SCORE_CONSECUTIVE + SCORE_BOUNDARY;
+    score_max_lower += SCORE_MATCH + SCORE_CONSECUTIVE;
+
+    if (c < 0x80 && !isalnum(c))
+      score_max_lower += SCORE_BOUNDARY;
+  }
+}
+
+/* ====================================================================== */
+/* Returns 1 if the ranked word a is worse than b: a lower score or, for  */
+/* the same score, a later position in the input.                         */
+/* ====================================================================== */
+int
+ranked_word_worse(ranked_word_t *a, ranked_word_t *b)
+{
+  return a->score < b->score || (a->score == b->score && a->index > b->index);
+}
+
+/* ====================================================================== */
+/* Restores the heap property of the nb first elements of ranked_words_da */
+/* from the element i downwards, the root being the worst ranked word.    */
+/* ====================================================================== */
+void
+ranked_words_sift_down(long i, long nb)
+{
+  ranked_word_t tmp;
+  long          child;
+
+  while ((child = 2 * i + 1) < nb)
+  {
+    if (child + 1 < nb
+        && ranked_word_worse(&ranked_words_da[child + 1],
+                             &ranked_words_da[child]))
+      child++;
+
+    if (!ranked_word_worse(&ranked_words_da[child], &ranked_words_da[i]))
+      break;
+
+    tmp                    = ranked_words_da[i];
+    ranked_words_da[i]     = ranked_words_da[child];
+    ranked_words_da[child] = tmp;
+
+    i = child;
+  }
+}
+
+/* ====================================================================== */
+/* Offers the word n with the given score to the heap of the              */
+/* RANKED_WORDS_NB best ranked fuzzy matches. When the heap is full, the  */
+/* word replaces its root if it is better, so each word costs at most     */
+/* O(log(RANKED_WORDS_NB)).                                               */
+/* ====================================================================== */
+void
+rank_word(long n, long score)
+{
+  ranked_word_t word = { n, score };
+  long          i;
+
+  if (BUF_LEN(ranked_words_da) < RANKED_WORDS_NB)
+  {
+    /* Sift the new word up. */
+    /* """"""""""""""""""""" */
+    BUF_PUSH(ranked_words_da, word);
+
+    i = BUF_LEN(ranked_words_da) - 1;
+    while (i > 0
+           && ranked_word_worse(&ranked_words_da[i],
+                                &ranked_words_da[(i - 1) / 2]))
     {
-      n      = matching_words_da[i];
-      bm     = word_a[n].bitmap;
-      bm_len = (word_a[n].mb - daccess.flength) / CHAR_BIT + 1;
+      ranked_word_t tmp = ranked_words_da[i];
 
-      memset(bm, '\0', bm_len);
+      ranked_words_da[i]           = ranked_words_da[(i - 1) / 2];
+      ranked_words_da[(i - 1) / 2] = tmp;
 
-      for (j = 0; j <= last; j++)
-        BIT_ON(bm, j + word_a[n].offset);
+      i = (i - 1) / 2;
     }
   }
+  else if (ranked_word_worse(&ranked_words_da[0], &word))
+  {
+    ranked_words_da[0] = word;
+    ranked_words_sift_down(0, BUF_LEN(ranked_words_da));
+  }
+}
+
+/* ====================================================================== */
+/* Turns the heap of the best ranked words into an array sorted from the  */
+/* best to the worst.                                                     */
+/* ====================================================================== */
+void
+sort_ranked_words(void)
+{
+  for (long nb = BUF_LEN(ranked_words_da) - 1; nb > 0; nb--)
+  {
+    ranked_word_t tmp = ranked_words_da[0];
+
+    ranked_words_da[0]  = ranked_words_da[nb];
+    ranked_words_da[nb] = tmp;
+
+    ranked_words_sift_down(0, nb);
+  }
 }
 
 /* ========================================================= */
@@ -1943,13 +2432,15 @@ clean_matches(search_data_t *search_data, long size)
       sub_tst_data = (sub_tst_t *)(fuzzy_node->data);
 
       free(sub_tst_data->array);
+      free(sub_tst_data->cands);
       free(sub_tst_data);
 
       ll_delete(tst_search_list, tst_search_list->tail);
       fuzzy_node = tst_search_list->tail;
     }
-    sub_tst_data        = (sub_tst_t *)(fuzzy_node->data);
-    sub_tst_data->count = 0;
+    sub_tst_data           = (sub_tst_t *)(fuzzy_node->data);
+    sub_tst_data->count    = 0;
+    sub_tst_data->nb_cands = 0;
   }
 
   search_data->err = 0;
@@ -1970,11 +2461,91 @@ clean_matches(search_data_t *search_data, long size)
     long n = matching_words_da[i];
 
     word_a[n].is_matching = 0;
-
-    clear_bitmap(&word_a[n]);
   }
 
+  invalidate_bitmaps();
+
   BUF_CLEAR(matching_words_da);
+
+  clear_saved_matching_words();
+}
+
+/* ====================================================================== */
+/* Empties matching_words_da before a new search step. When the search    */
+/* string has grown from old_mb_len to mb_len glyphs, its content is      */
+/* saved in matching_words_stack_da instead.                              */
+/* The stack only contains the sets of matching words of the successive   */
+/* prefixes of the search string, so nothing is saved if one is missing.  */
+/* ====================================================================== */
+void
+save_matching_words(long old_mb_len, long mb_len)
+{
+  if (old_mb_len > 0 && mb_len == old_mb_len + 1
+      && (long)BUF_LEN(matching_words_stack_da) == old_mb_len - 1)
+  {
+    BUF_PUSH(matching_words_stack_da, matching_words_da);
+    matching_words_da = NULL;
+  }
+  else
+    BUF_CLEAR(matching_words_da);
+}
+
+/* ====================================================================== */
+/* Restores in matching_words_da the set of matching words of the search  */
+/* string of mb_len glyphs, typically after a backspace, without having   */
+/* to search it again. The words of the previous set must already have    */
+/* been unmarked.                                                         */
+/* Returns 0 if this set was not saved, 1 otherwise.                      */
+/* ====================================================================== */
+int
+restore_matching_words(long mb_len)
+{
+  long n;
+
+  if (mb_len == 0 || (long)BUF_LEN(matching_words_stack_da) != mb_len)
+    return 0;
+
+  BUF_FREE(matching_words_da);
+  matching_words_da = BUF_POP(matching_words_stack_da);
+
+  for (long i = 0; i < (long)BUF_LEN(matching_words_da); i++)
+  {
+    n = matching_words_da[i];
+
+    if (search_mode != FUZZY || word_a[n].is_selectable)
+      word_a[n].is_matching = 1;
+  }
+
+  return 1;
+}
+
+/* ================================================================== */
+/* Forgets the last set saved by save_matching_words when the glyph   */
+/* appended to the search string is finally rejected.                 */
+/* ================================================================== */
+void
+discard_saved_matching_words(long mb_len)
+{
+  long *set;
+
+  if (mb_len > 0 && (long)BUF_LEN(matching_words_stack_da) == mb_len)
+  {
+    set = BUF_POP(matching_words_stack_da);
+    BUF_FREE(set);
+  }
+}
+
+/* ================================================================ */
+/* Empties matching_words_stack_da, the saved sets are no longer    */
+/* valid when the search is restarted or restricted.                */
+/* ================================================================ */
+void
+clear_saved_matching_words(void)
+{
+  for (long i = 0; i < (long)BUF_LEN(matching_words_stack_da); i++)
+    BUF_FREE(matching_words_stack_da[i]);
+
+  BUF_CLEAR(matching_words_stack_da);
 }
 
 /* *************************** */
@@ -1996,6 +2567,21 @@ outch(int c)
   return 1;
 }
 
+/* =================================================================== */
+/* Version of outch writing on the terminal used to display the number */
+/* of words read, see disp_reading_progress.                           */
+/* =================================================================== */
+int
+#ifdef __sun
+outch_progress(char c)
+#else
+outch_progress(int c)
+#endif
+{
+  fputc_safe(c, progress_tty);
+  return 1;
+}
+
 /* =============================================== */
 /* Set the terminal in non echo/non canonical mode */
 /* wait for at least one byte, no timeout.         */
@@ -3444,34 +4030,25 @@ strip_ansi_color(char *s, toggle_t *toggles, misc_t *misc)
 }
 
 /* ================================================================== */
-/* Callback function used by tst_traverse to insert the index         */
-/* of a matching word index in the sorted list of the already matched */
-/* words.                                                             */
+/* Callback function used by tst_traverse to add the index of a       */
+/* matching word in the set of the already matched words, see         */
+/* collect_matching_words.                                            */
 /* Always succeeds and returns 1.                                     */
 /* ================================================================== */
 int
 set_matching_flag(void *elem)
 {
-  ll_t *list = (ll_t *)elem;
+  posting_iter_t it;
+  long           pos;
 
-  ll_node_t *node = list->head;
-  long       target;
+  posting_iter_init(&it, (posting_t *)elem);
 
-  while (node)
+  while (posting_iter_next(&it, &pos))
   {
-    size_t pos;
-
-    pos = *(size_t *)(node->data);
     if (word_a[pos].is_selectable)
       word_a[pos].is_matching = 1;
 
-    target = get_sorted_array_target_pos(matching_words_da,
-                                         BUF_LEN(matching_words_da),
-                                         pos);
-    if (target >= 0)
-      BUF_INSERT(matching_words_da, target, pos);
-
-    node = node->next;
+    BIT_ON(matching_words_bits, pos);
   }
   return 1;
 }
@@ -3480,42 +4057,77 @@ set_matching_flag(void *elem)
 /* Callback function used by tst_traverse applied to tst_word so this      */
 /* function is applied on each node of this tst.                           */
 /*                                                                         */
-/* Each node of this tst contains a linked list storing the indexes of     */
+/* Each node of this tst contains a posting list storing the indexes of    */
 /* the words in the input flow.                                            */
 /* Each position in this list is used to:                                  */
 /* - mark the word at that position as matching,                           */
-/* - add this position in the sorted array matching_words_da.              */
+/* - add this position in the set of the matching words, see               */
+/*   collect_matching_words.                                               */
 /* Always succeeds and returns 1.                                          */
 /* ======================================================================= */
 int
 tst_search_cb(void *elem)
 {
-  /* The data attached to the string in the tst is a linked list of   */
-  /* position of the string in the input flow, This list is naturally */
-  /* sorted.                                                          */
-  /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
-  ll_t *list = (ll_t *)elem;
+  /* The data attached to the string in the tst is a posting list of    */
+  /* positions of the string in the input flow, This list is naturally  */
+  /* sorted.                                                            */
+  /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+  posting_iter_t it;
+  long           pos;
 
-  ll_node_t *node = list->head;
-  long       target;
+  posting_iter_init(&it, (posting_t *)elem);
 
-  while (node)
+  while (posting_iter_next(&it, &pos))
   {
-    long pos;
+    word_a[pos].is_matching = 1;
 
-    pos = *(long *)(node->data);
+    BIT_ON(matching_words_bits, pos);
+  }
+  return 1; /* OK. */
+}
 
-    word_a[pos].is_matching = 1;
+/* ====================================================================== */
+/* Moves the word indexes collected in matching_words_bits to the empty   */
+/* array matching_words_da. A single pass over the bit array is enough to */
+/* get them sorted and without duplicates, whatever the order in which    */
+/* they were found.                                                       */
+/* ====================================================================== */
+void
+collect_matching_words(void)
+{
+  long nb = count / CHAR_BIT + 1;
 
-    target = get_sorted_array_target_pos(matching_words_da,
-                                         BUF_LEN(matching_words_da),
-                                         pos);
-    if (target >= 0)
-      BUF_INSERT(matching_words_da, target, pos);
+  for (long i = 0; i < nb; i++)
+  {
+    if (matching_words_bits[i] == 0)
+      continue;
 
-    node = node->next;
+    for (long j = i * CHAR_BIT; j < (i + 1) * CHAR_BIT; j++)
+      if (BIT_ISSET(matching_words_bits, j))
+        BUF_PUSH(matching_words_da, j);
+
+    matching_words_bits[i] = 0;
   }
-  return 1; /* OK. */
+}
+
+/* ================================================================== */
+/* qsort comparison function for the keys of tst_word.                */
+/* The UTF-8 byte order is also the code point order used by the tst. */
+/* Equal keys are ordered by word index to keep the posting lists     */
+/* sorted.                                                            */
+/* ================================================================== */
+int
+tst_key_cmp(const void *a, const void *b)
+{
+  const tst_key_t *ka = a;
+  const tst_key_t *kb = b;
+
+  int rc;
+
+  if ((rc = strcmp(ka->str, kb->str)) != 0)
+    return rc;
+
+  return (ka->pos > kb->pos) - (ka->pos < kb->pos);
 }
 
 /* **************** */
@@ -3605,17 +4217,17 @@ buffer_cmp(const void *a, const void *b)
 }
 
 /* ===================================================================== */
-/* Get bytes from stdin. If the first byte is the leading character of a */
-/* UTF-8 glyph, the following ones are also read.                        */
+/* Get bytes from the buffered input. If the first byte is the leading   */
+/* character of a UTF-8 glyph, the following ones are also read.         */
 /* The utf8_get_length function is used to get the number of bytes of    */
 /* the character.                                                        */
 /* ===================================================================== */
 int
-read_bytes(FILE       *input,
-           char       *buffer,
-           ll_t       *zapped_glyphs_list,
-           langinfo_t *langinfo,
-           misc_t     *misc)
+read_bytes(in_buf_t      *input,
+           char          *buffer,
+           glyph_class_t *glyph_classes,
+           langinfo_t    *langinfo,
+           misc_t        *misc)
 {
   int byte;
   int last;
@@ -3627,7 +4239,7 @@ read_bytes(FILE       *input,
 
     /* Read the first byte. */
     /* """""""""""""""""""" */
-    byte = my_fgetc(input);
+    byte = IN_BUF_GETC(input);
 
     if (byte == EOF)
       return EOF;
@@ -3639,7 +4251,7 @@ read_bytes(FILE       *input,
     /* """""""""""""""""""""""""""""""""""""""""""""""""""""" */
     if (langinfo->utf8 && ((n = utf8_get_length(byte)) > 1))
     {
-      while (last < n && (byte = my_fgetc(input)) != EOF
+      while (last < n && (byte = IN_BUF_GETC(input)) != EOF
              && (byte & 0xc0) == 0x80)
         buffer[last++] = byte;
 
@@ -3658,7 +4270,7 @@ read_bytes(FILE       *input,
       byte = buffer[0] = misc->invalid_char_substitute;
       buffer[1]        = '\0';
     }
-  } while (ll_find(zapped_glyphs_list, buffer, buffer_cmp) != NULL);
+  } while (GLYPH_CLASS(glyph_classes, buffer) & ZAPPED_GLYPH);
 
   return byte;
 }
@@ -3796,17 +4408,15 @@ expand(char       *src,
 
 /* ====================================================================== */
 /* read_word(input): return a char pointer to the next word (as a string) */
-/* Accept: a FILE * for the input stream.                                 */
+/* Accept: a buffered reader for the input stream.                        */
 /* Return: a char *                                                       */
 /*    On Success: the return value will point to a nul-terminated         */
 /*                string.                                                 */
 /*    On Failure: the return value will be set to NULL.                   */
 /* ====================================================================== */
 char *
-read_word(FILE          *input,
-          ll_t          *word_delims_list,
-          ll_t          *line_delims_list,
-          ll_t          *zapped_glyphs_list,
+read_word(in_buf_t      *input,
+          glyph_class_t *glyph_classes,
           char          *buffer,
           unsigned char *is_last,
           toggle_t      *toggles,
@@ -3815,27 +4425,44 @@ read_word(FILE          *input,
           limit_t       *limits,
           misc_t        *misc)
 {
-  char         *temp = NULL;
-  int           byte;
-  long          byte_count = 0; /* count chars used in current allocation. */
-  long          wordsize;       /* size of current allocation in chars.    */
-  unsigned char is_dquote;      /* double quote presence indicator.        */
-  unsigned char is_squote;      /* single quote presence indicator.        */
-  int           is_special;     /* a character is special after a \        */
+  static char   *temp     = NULL; /* work buffer reused for every word.      */
+  static long    wordsize = 0;    /* size of this buffer in chars.           */
+  char          *word;            /* the word returned.                      */
+  int            byte;
+  long           byte_count = 0; /* count chars used in the work buffer.    */
+  unsigned char  is_dquote;      /* double quote presence indicator.        */
+  unsigned char  is_squote;      /* single quote presence indicator.        */
+  int            is_special;     /* a character is special after a \        */
+  unsigned char *slice = NULL;   /* start of the word in a memory mapped    *
+                                  | input while it can be used unaltered.   */
+  size_t         slice_len = 0;  /* number of bytes in this slice.          */
 
   /* Skip leading delimiters. */
   /* """""""""""""""""""""""" */
   do
-    byte = read_bytes(input, buffer, zapped_glyphs_list, langinfo, misc);
-  while (byte != EOF && ll_find(word_delims_list, buffer, buffer_cmp) != NULL);
+    byte = read_bytes(input, buffer, glyph_classes, langinfo, misc);
+  while (byte != EOF
+         && (GLYPH_CLASS(glyph_classes, buffer) & WORD_DELIM_GLYPH));
 
   if (byte == EOF)
     return NULL;
 
-  /* Allocate initial word storage space. */
-  /* """""""""""""""""""""""""""""""""""" */
-  wordsize = CHARSCHUNK;
-  temp     = xmalloc(wordsize);
+  /* Allocate initial work buffer space. */
+  /* """"""""""""""""""""""""""""""""""" */
+  if (temp == NULL)
+  {
+    wordsize = CHARSCHUNK;
+    temp     = xmalloc(wordsize);
+  }
+
+  /* When the input is memory mapped, the word is first taken as a slice */
+  /* of the mapping and is only copied if it needs to be altered.        */
+  /* Nul-terminating the slices still makes the system copy the pages of */
+  /* the private mapping, so the words take about the size of the file   */
+  /* in memory, but without any per word allocation overhead.            */
+  /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+  if (input->mapped)
+    slice = input->data + input->pos - strlen(buffer);
 
   /* Start stashing bytes. Stop when we meet a non delimiter or EOF. */
   /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
@@ -3848,6 +4475,38 @@ read_word(FILE          *input,
   {
     size_t i = 0;
 
+    /* Extend the slice as long as the glyphs read are the untouched    */
+    /* bytes following it in the mapping and do not need to be altered. */
+    /* In the other case copy it in the work buffer and continue        */
+    /* normally.                                                        */
+    /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+    if (slice != NULL)
+    {
+      size_t glyph_len = strlen(buffer);
+
+      if (GLYPH_CLASS(glyph_classes, buffer) & WORD_DELIM_GLYPH)
+        break;
+
+      if (byte != '\\' && byte != 0x1b
+          && (misc->ignore_quotes || (byte != '"' && byte != '\''))
+          && input->data + input->pos == slice + slice_len + glyph_len
+          && memcmp(slice + slice_len, buffer, glyph_len) == 0)
+      {
+        slice_len += glyph_len;
+        goto next;
+      }
+
+      if ((long)slice_len >= wordsize)
+      {
+        wordsize = ((long)slice_len / CHARSCHUNK + 1) * CHARSCHUNK;
+        temp     = xrealloc(temp, wordsize);
+      }
+
+      byte_count = slice_len;
+      memcpy(temp, slice, slice_len);
+      slice = NULL;
+    }
+
     if (byte == '\\' && !is_special)
     {
       is_special = 1;
@@ -3930,7 +4589,7 @@ read_word(FILE          *input,
     /* Only consider delimiters when outside quotations. */
     /* """"""""""""""""""""""""""""""""""""""""""""""""" */
     if ((!is_dquote && !is_squote)
-        && ll_find(word_delims_list, buffer, buffer_cmp) != NULL)
+        && (GLYPH_CLASS(glyph_classes, buffer) & WORD_DELIM_GLYPH))
       break;
 
     /* We no dot count the significant quotes. */
@@ -3957,27 +4616,76 @@ read_word(FILE          *input,
     is_special = 0;
 
   next:
-    byte = read_bytes(input, buffer, zapped_glyphs_list, langinfo, misc);
+    /* Copy at once the following run of plain ASCII characters which */
+    /* would otherwise have been processed one by one above.          */
+    /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+    if (!is_special)
+    {
+      size_t run = glyph_class_span(glyph_classes,
+                                    input->data + input->pos,
+                                    input->end - input->pos);
+
+      if (run > 0)
+      {
+        if (slice != NULL)
+          slice_len += run;
+        else
+        {
+          if (byte_count + (long)run >= wordsize)
+          {
+            wordsize = ((byte_count + (long)run) / CHARSCHUNK + 1) * CHARSCHUNK;
+            temp     = xrealloc(temp, wordsize);
+          }
+
+          memcpy(temp + byte_count, input->data + input->pos, run);
+          byte_count += (long)run;
+        }
+
+        input->pos += run;
+      }
+    }
+
+    byte = read_bytes(input, buffer, glyph_classes, langinfo, misc);
   }
 
-  /* Nul-terminate the word to make it a string. */
-  /* """"""""""""""""""""""""""""""""""""""""""" */
-  *(temp + byte_count) = '\0';
+  if (slice != NULL)
+  {
+    /* The word is still a slice of the mapping, the first byte of */
+    /* the delimiter which ended it, already consumed, can be      */
+    /* overwritten to nul-terminate it. A word ended by the end of */
+    /* the mapping must be copied.                                 */
+    /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+    if (byte != EOF)
+    {
+      slice[slice_len] = '\0';
+      word             = (char *)slice;
+    }
+    else
+      word = arena_strndup(word_arena, (char *)slice, slice_len);
+  }
+  else
+  {
+    /* Nul-terminate the word to make it a string. */
+    /* """"""""""""""""""""""""""""""""""""""""""" */
+    *(temp + byte_count) = '\0';
 
-  /* Replace the UTF-8 ASCII representations in the word just */
-  /* read by their binary values.                             */
-  /* """""""""""""""""""""""""""""""""""""""""""""""""""""""" */
-  utf8_interpret(temp, misc->invalid_char_substitute);
+    /* Replace the UTF-8 ASCII representations in the word just */
+    /* read by their binary values.                             */
+    /* """""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+    utf8_interpret(temp, misc->invalid_char_substitute);
+  }
 
   /* Skip all field delimiters before a record delimiter. */
   /* """""""""""""""""""""""""""""""""""""""""""""""""""" */
-  if (ll_find(line_delims_list, buffer, buffer_cmp) == NULL)
+  if (!(GLYPH_CLASS(glyph_classes, buffer) & LINE_DELIM_GLYPH))
   {
-    byte = read_bytes(input, buffer, zapped_glyphs_list, langinfo, misc);
+    byte = read_bytes(input, buffer, glyph_classes, langinfo, misc);
 
-    while (byte != EOF && ll_find(word_delims_list, buffer, buffer_cmp) != NULL
-           && ll_find(line_delims_list, buffer, buffer_cmp) == NULL)
-      byte = read_bytes(input, buffer, zapped_glyphs_list, langinfo, misc);
+    while (byte != EOF
+           && (GLYPH_CLASS(glyph_classes, buffer)
+               & (WORD_DELIM_GLYPH | LINE_DELIM_GLYPH))
+                == WORD_DELIM_GLYPH)
+      byte = read_bytes(input, buffer, glyph_classes, langinfo, misc);
 
     if (byte != EOF)
     {
@@ -3987,10 +4695,10 @@ read_word(FILE          *input,
 
         pos = strlen(buffer);
         while (pos > 0)
-          my_ungetc(buffer[--pos], input);
+          in_buf_ungetc(buffer[--pos], input);
       }
       else
-        my_ungetc(byte, input);
+        in_buf_ungetc(byte, input);
     }
   }
 
@@ -3999,16 +4707,21 @@ read_word(FILE          *input,
   /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
   if (byte == EOF
       || ((win->col_mode || win->line_mode || win->tab_mode)
-          && ll_find(line_delims_list, buffer, buffer_cmp) != NULL))
+          && (GLYPH_CLASS(glyph_classes, buffer) & LINE_DELIM_GLYPH)))
     *is_last = 1;
   else
     *is_last = 0;
 
-  /* Remove the ANSI color escape sequences from the word. */
-  /* """"""""""""""""""""""""""""""""""""""""""""""""""""" */
-  strip_ansi_color(temp, toggles, misc);
+  /* Remove the ANSI color escape sequences from the word, a slice */
+  /* cannot contain any, and store it with the other words.        */
+  /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+  if (slice == NULL)
+  {
+    strip_ansi_color(temp, toggles, misc);
+    word = arena_strdup(word_arena, temp);
+  }
 
-  return temp;
+  return word;
 }
 
 /* ================================================================ */
@@ -4417,6 +5130,8 @@ set_win_start_end(win_t *win, long current, long last)
 /* Set win.start win.end and the starting and ending position of each word. */
 /* This function is only called initially, when resizing the terminal and   */
 /* potentially when the search function is used.                            */
+/* The lines are only rebuilt when the terminal width has changed, else     */
+/* only the part of them to display is determined again.                    */
 /*                                                                          */
 /* Returns the number of the last line built.                               */
 /* ======================================================================== */
@@ -4433,6 +5148,17 @@ build_metadata(term_t *term, long count, win_t *win)
                         | tab_mode.                                     */
   wchar_t *w;
 
+  /* The lines only depend on the words and on the terminal width, */
+  /* there is nothing to rebuild if this width has not changed.    */
+  /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+  if (win->layout_width == term->ncolumns)
+  {
+    last = line_nb_of_word_a[count - 1];
+    set_win_start_end(win, current, last);
+
+    return last;
+  }
+
   line_nb_of_word_a[0]    = 0;
   first_word_in_line_a[0] = 0;
 
@@ -4448,20 +5174,28 @@ build_metadata(term_t *term, long count, win_t *win)
   tab_count = 0;
   while (i < count)
   {
-    /* Determine the number of screen positions taken by the word. */
-    /* Note: mbstowcs will always succeed here as word_a[i].str    */
-    /*       has already been utf8_validated/repaired.             */
-    /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
-    word_len   = mbstowcs(NULL, word_a[i].str, 0);
-    word_width = my_wcswidth((w = utf8_strtowcs(word_a[i].str)), word_len);
+    /* The number of glyphs and the width of each word have been */
+    /* computed once for all after the words were read.          */
+    /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+    word_len   = word_a[i].nb_glyphs;
+    word_width = word_a[i].width;
 
     /* Manage the case where the word is larger than the terminal width: */
     /* Shorten the word until it fits.                                   */
+    /* The shortened word keeps one glyph less than what my_wcswidth_fit */
+    /* accepts, the width remains the one of the longer prefix.          */
     /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
-    while (word_width >= term->ncolumns - 2 && word_len > 0)
-      word_width = my_wcswidth(w, word_len--);
+    if (word_width >= term->ncolumns - 2 && word_len > 0)
+    {
+      int fit_width;
 
-    free(w);
+      w          = utf8_strtowcs(word_cold_a[i].str);
+      word_len   = my_wcswidth_fit(w, word_len, term->ncolumns - 2, &fit_width);
+      word_width = fit_width;
+      word_len--;
+
+      free(w);
+    }
 
     /* Look if there is enough remaining place on the line when not in   */
     /* column mode. Force a break if the 'is_last' flag is set in all    */
@@ -4527,6 +5261,8 @@ build_metadata(term_t *term, long count, win_t *win)
   else
     win->offset = (term->ncolumns - 2 - win->max_width) / 2;
 
+  win->layout_width = term->ncolumns;
+
   /* We need to recalculate win->start and win->end here */
   /* because of a possible terminal resizing.            */
   /* """"""""""""""""""""""""""""""""""""""""""""""""""" */
@@ -4542,17 +5278,17 @@ build_metadata(term_t *term, long count, win_t *win)
 void
 disp_cursor_word(long pos, win_t *win, term_t *term, int err)
 {
-  size_t i;
-  int    att_set = 0;
-  char  *p       = word_a[pos].str + daccess.flength;
-  char  *np;
+  long  i;
+  int   att_set = 0;
+  char *p       = word_cold_a[pos].str + daccess.flength;
+  char *np;
 
   /* Set the cursor attribute. */
   /* """"""""""""""""""""""""" */
   (void)tputs(TPARM1(exit_attribute_mode), 1, outch);
 
   (void)tputs(TPARM1(exit_attribute_mode), 1, outch);
-  if (word_a[pos].tag_id > 0)
+  if (word_cold_a[pos].tag_id > 0)
   {
     if (marked == -1)
       apply_attr(term, win->cursor_on_tag_attr);
@@ -4569,7 +5305,7 @@ disp_cursor_word(long pos, win_t *win, term_t *term, int err)
 
   for (i = 0; i < word_a[pos].mb - daccess.flength; i++)
   {
-    if (BIT_ISSET(word_a[pos].bitmap, i))
+    if (BIT_ISSET(word_bitmap(pos), i))
     {
       if (!att_set)
       {
@@ -4583,7 +5319,7 @@ disp_cursor_word(long pos, win_t *win, term_t *term, int err)
         else
           apply_attr(term, win->match_text_attr);
 
-        if (word_a[pos].tag_id > 0)
+        if (word_cold_a[pos].tag_id > 0)
         {
           if (marked == -1)
             apply_attr(term, win->cursor_on_tag_attr);
@@ -4608,7 +5344,7 @@ disp_cursor_word(long pos, win_t *win, term_t *term, int err)
         /* Set the search cursor attribute. */
         /* """""""""""""""""""""""""""""""" */
         (void)tputs(TPARM1(exit_attribute_mode), 1, outch);
-        if (word_a[pos].tag_id > 0)
+        if (word_cold_a[pos].tag_id > 0)
         {
           if (marked == -1)
             apply_attr(term, win->cursor_on_tag_attr);
@@ -4640,9 +5376,9 @@ disp_cursor_word(long pos, win_t *win, term_t *term, int err)
 void
 disp_matching_word(long pos, win_t *win, term_t *term, int is_current, int err)
 {
-  size_t        i;
+  long          i;
   int           att_set = 0;
-  char         *p       = word_a[pos].str + daccess.flength;
+  char         *p       = word_cold_a[pos].str + daccess.flength;
   char         *np;
   unsigned char level = 0;
 
@@ -4672,12 +5408,12 @@ disp_matching_word(long pos, win_t *win, term_t *term, int is_current, int err)
       apply_attr(term, win->search_field_attr);
   }
 
-  if (word_a[pos].tag_id > 0)
+  if (word_cold_a[pos].tag_id > 0)
     apply_attr(term, win->tag_attr);
 
   for (i = 0; i < word_a[pos].mb - daccess.flength; i++)
   {
-    if (BIT_ISSET(word_a[pos].bitmap, i))
+    if (BIT_ISSET(word_bitmap(pos), i))
     {
       if (!att_set)
       {
@@ -4696,7 +5432,7 @@ disp_matching_word(long pos, win_t *win, term_t *term, int is_current, int err)
         else
           apply_attr(term, win->search_text_attr);
 
-        if (word_a[pos].tag_id > 0)
+        if (word_cold_a[pos].tag_id > 0)
           apply_attr(term, win->tag_attr);
       }
     }
@@ -4729,7 +5465,7 @@ disp_matching_word(long pos, win_t *win, term_t *term, int is_current, int err)
             apply_attr(term, win->search_field_attr);
         }
 
-        if (word_a[pos].tag_id > 0)
+        if (word_cold_a[pos].tag_id > 0)
           apply_attr(term, win->tag_attr);
       }
     }
@@ -4769,7 +5505,7 @@ disp_word(long           pos,
   {
     if (search_mode != NONE)
     {
-      utf8_strprefix(tmp_word, word_a[pos].str, (long)word_a[pos].mb, &p);
+      utf8_strprefix(tmp_word, word_cold_a[pos].str, (long)word_a[pos].mb, &p);
       if (word_a[pos].is_numbered)
       {
         /* Set the direct access number attribute. */
@@ -4801,7 +5537,7 @@ disp_word(long           pos,
 
       /* The tab attribute must complete the attributes already set. */
       /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
-      if (word_a[pos].tag_id > 0)
+      if (word_cold_a[pos].tag_id > 0)
         apply_attr(term, win->tag_attr);
 
       /* Print the word part. */
@@ -4841,7 +5577,7 @@ disp_word(long           pos,
           /* Print the non significant part of the word. */
           /* """"""""""""""""""""""""""""""""""""""""""" */
           (void)tputs(TPARM1(exit_attribute_mode), 1, outch);
-          printf("%.*s", daccess.flength - 1, word_a[pos].str);
+          printf("%.*s", daccess.flength - 1, word_cold_a[pos].str);
           (void)tputs(TPARM1(exit_attribute_mode), 1, outch);
           fputc_safe(' ', stdout);
         }
@@ -4852,7 +5588,7 @@ disp_word(long           pos,
           /* Print the non significant part of the word. */
           /* """"""""""""""""""""""""""""""""""""""""""" */
           fputs_safe(daccess.left, stdout);
-          printf("%.*s", daccess.length, word_a[pos].str + 1);
+          printf("%.*s", daccess.length, word_cold_a[pos].str + 1);
           fputs_safe(daccess.right, stdout);
           (void)tputs(TPARM1(exit_attribute_mode), 1, outch);
           fputc_safe(' ', stdout);
@@ -4861,12 +5597,12 @@ disp_word(long           pos,
 
       /* If we are not in search mode, display a normal cursor. */
       /* """""""""""""""""""""""""""""""""""""""""""""""""""""" */
-      utf8_strprefix(tmp_word, word_a[pos].str, (long)word_a[pos].mb, &p);
+      utf8_strprefix(tmp_word, word_cold_a[pos].str, (long)word_a[pos].mb, &p);
       if (word_a[pos].is_matching)
         disp_cursor_word(pos, win, term, search_data->err);
       else
       {
-        if (word_a[pos].tag_id > 0)
+        if (word_cold_a[pos].tag_id > 0)
         {
           if (marked == -1)
             apply_attr(term, win->cursor_on_tag_attr);
@@ -4900,7 +5636,7 @@ disp_word(long           pos,
   {
     /* Display a normal word without any attribute. */
     /* """""""""""""""""""""""""""""""""""""""""""" */
-    utf8_strprefix(tmp_word, word_a[pos].str, (long)word_a[pos].mb, &p);
+    utf8_strprefix(tmp_word, word_cold_a[pos].str, (long)word_a[pos].mb, &p);
 
     /* If words are numbered, emphasis their numbers. */
     /* """""""""""""""""""""""""""""""""""""""""""""" */
@@ -4940,8 +5676,8 @@ disp_word(long           pos,
       apply_attr(term, win->marked_attr);
     else
     {
-      if (word_a[pos].iattr != NULL) /* is a specific attribute set? */
-        apply_attr(term, *(word_a[pos].iattr));
+      if (word_cold_a[pos].iattr != NULL) /* is a specific attribute set? */
+        apply_attr(term, *(word_cold_a[pos].iattr));
       else
         apply_attr(term, win->include_attr);
     }
@@ -4950,7 +5686,7 @@ disp_word(long           pos,
       disp_matching_word(pos, win, term, 0, search_data->err);
     else
     {
-      if (word_a[pos].tag_id > 0)
+      if (word_cold_a[pos].tag_id > 0)
         apply_attr(term, win->tag_attr);
 
       if ((daccess.length > 0 && daccess.padding == 'a')
@@ -5234,6 +5970,74 @@ disp_message(ll_t       *message_lines_list,
   sigprocmask(SIG_UNBLOCK, &mask, NULL);
 }
 
+/* ===================================================================== */
+/* Displays on progress_tty the number of words already read when the    */
+/* input is slow to arrive, so that the user does not face a blank       */
+/* screen. The message only appears after half a second and is refreshed */
+/* ten times per second at most. The clock is only read every            */
+/* PROGRESS_WORDS words to keep the cost per word negligible.            */
+/* A negative count erases the message if it has been displayed.         */
+/* Nothing is done if progress_tty is NULL.                              */
+/* ===================================================================== */
+void
+disp_reading_progress(long count)
+{
+  static struct timespec start;
+  static struct timespec last;
+  static int             started = 0;
+  static int             shown   = 0;
+
+  struct timespec now;
+  long            elapsed_ms;
+
+  if (progress_tty == NULL)
+    return;
+
+  if (count < 0)
+  {
+    if (shown)
+    {
+      (void)tputs(TPARM1(carriage_return), 1, outch_progress);
+      (void)tputs(TPARM1(clr_eol), 1, outch_progress);
+      fflush(progress_tty);
+      shown = 0;
+    }
+    return;
+  }
+
+  if (started && count % PROGRESS_WORDS != 0)
+    return;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  if (!started)
+  {
+    start = last = now;
+    started      = 1;
+    return;
+  }
+
+  elapsed_ms = (now.tv_sec - start.tv_sec) * 1000
+               + (now.tv_nsec - start.tv_nsec) / 1000000;
+
+  if (elapsed_ms < 500)
+    return;
+
+  elapsed_ms = (now.tv_sec - last.tv_sec) * 1000
+               + (now.tv_nsec - last.tv_nsec) / 1000000;
+
+  if (shown && elapsed_ms < 100)
+    return;
+
+  (void)tputs(TPARM1(carriage_return), 1, outch_progress);
+  fprintf(progress_tty, "Reading... %ld words", count);
+  (void)tputs(TPARM1(clr_eol), 1, outch_progress);
+  fflush(progress_tty);
+
+  last  = now;
+  shown = 1;
+}
+
 /* ============================= */
 /* Display the selection window. */
 /* ============================= */
@@ -5851,7 +6655,7 @@ select_ending_matches(win_t         *win,
     for (i = 0; i < (long)BUF_LEN(matching_words_da); i++)
     {
       index     = matching_words_da[i];
-      char *str = word_a[index].str;
+      char *str = word_cold_a[index].str;
 
       /* count the trailing blanks non counted in the bitmap. */
       /* """""""""""""""""""""""""""""""""""""""""""""""""""" */
@@ -5876,7 +6680,7 @@ select_ending_matches(win_t         *win,
       /* If set we add the index to an alternate array, if not we */
       /* clear the bitmap of the corresponding word.              */
       /* """""""""""""""""""""""""""""""""""""""""""""""""""""""" */
-      if (BIT_ISSET(word_a[index].bitmap,
+      if (BIT_ISSET(word_bitmap(index),
                     word_a[index].mb - nb - daccess.flength - 1))
         BUF_PUSH(alt_matching_words_da, index);
       else
@@ -5894,7 +6698,7 @@ select_ending_matches(win_t         *win,
           if (memcmp(ptr, last_glyph, mb_len) == 0)
             BUF_PUSH(alt_matching_words_da, index);
           else
-            clear_bitmap(&word_a[index]);
+            clear_bitmap(index);
         }
         else
         {
@@ -5905,7 +6709,7 @@ select_ending_matches(win_t         *win,
           if (memcmp(ptr, search_data->buf, search_data->len) == 0)
             BUF_PUSH(alt_matching_words_da, index);
           else
-            clear_bitmap(&word_a[index]);
+            clear_bitmap(index);
         }
       }
     }
@@ -5945,13 +6749,13 @@ select_starting_matches(win_t         *win,
 {
   if (BUF_LEN(matching_words_da) > 0)
   {
-    long   i;
-    long   index;
-    size_t nb;
-    long  *tmp;
-    long   pos;
-    char  *first_glyph;
-    int    mb_len;
+    long  i;
+    long  index;
+    long  nb;
+    long *tmp;
+    long  pos;
+    char *first_glyph;
+    int   mb_len;
 
     BUF_FREE(alt_matching_words_da);
     BUF_FIT(alt_matching_words_da, BUF_LEN(matching_words_da));
@@ -5963,10 +6767,10 @@ select_starting_matches(win_t         *win,
       index = matching_words_da[i];
 
       for (nb = 0; nb < word_a[index].mb; nb++)
-        if (!isblank(*(word_a[index].str + daccess.flength + nb)))
+        if (!isblank(*(word_cold_a[index].str + daccess.flength + nb)))
           break;
 
-      if (BIT_ISSET(word_a[index].bitmap, nb))
+      if (BIT_ISSET(word_bitmap(index), nb))
         BUF_PUSH(alt_matching_words_da, index);
       else
       {
@@ -5974,7 +6778,8 @@ select_starting_matches(win_t         *win,
         if (search_mode == FUZZY)
         {
           first_glyph = utf8_strprefix(first_glyph,
-                                       word_a[index].str + nb + daccess.flength,
+                                       word_cold_a[index].str + nb
+                                         + daccess.flength,
                                        1,
                                        &pos);
 
@@ -5985,19 +6790,19 @@ select_starting_matches(win_t         *win,
           if (memcmp(search_data->buf, first_glyph, mb_len) == 0)
             BUF_PUSH(alt_matching_words_da, index);
           else
-            clear_bitmap(&word_a[index]);
+            clear_bitmap(index);
         }
         else
         {
           /* in not fuzzy search mode use all the pattern. */
           /* """"""""""""""""""""""""""""""""""""""""""""" */
           if (memcmp(search_data->buf,
-                     word_a[index].str + nb,
+                     word_cold_a[index].str + nb,
                      search_data->len - nb)
               == 0)
             BUF_PUSH(alt_matching_words_da, index);
           else
-            clear_bitmap(&word_a[index]);
+            clear_bitmap(index);
         }
       }
     }
@@ -6060,7 +6865,7 @@ move_left(win_t         *win,
         }
         win->start = wi;
 
-        if (word_a[wi].str != NULL)
+        if (word_cold_a[wi].str != NULL)
           win->start = wi;
 
         if (win->end < count - 1)
@@ -6068,7 +6873,7 @@ move_left(win_t         *win,
           for (wi = win->end + 2; wi < count - 1 && word_a[wi].start != 0; wi++)
           {
           }
-          if (word_a[wi].str != NULL)
+          if (word_cold_a[wi].str != NULL)
             win->end = wi;
         }
       }
@@ -6219,7 +7024,7 @@ move_right(win_t         *win,
         {
         }
 
-        if (word_a[wi].str != NULL)
+        if (word_cold_a[wi].str != NULL)
           win->start = wi;
 
         if (win->end < count - 1)
@@ -6227,7 +7032,7 @@ move_right(win_t         *win,
           for (wi = win->end + 2; wi < count - 1 && word_a[wi].start != 0; wi++)
           {
           }
-          if (word_a[wi].str != NULL)
+          if (word_cold_a[wi].str != NULL)
             win->end = wi;
         }
       }
@@ -6954,6 +7759,7 @@ init_main_ds(attrib_t  *init_attr,
   win->real_max_width  = 0;
   win->sb_column       = -1;
   win->hbar_displayed  = 0;
+  win->layout_width    = 0;
 
   win->cursor_attr               = *init_attr;
   win->cursor_marked_attr        = *init_attr;
@@ -9048,6 +9854,10 @@ main(int argc, char *argv[])
 
   FILE *input_file; /* The name of the file passed as argument if any.       */
 
+  in_buf_t *input_buf; /* reader of the input, kept after the reading when   *
+                        | the input is memory mapped as words may point      *
+                        | inside the mapping.                                */
+
   long index; /* generic counter.                                            */
 
   long daccess_index = 1; /* First index of the numbered words.              */
@@ -9150,6 +9960,20 @@ main(int argc, char *argv[])
 
   tst_node_t *tst_word    = NULL; /* TST used by the search function.        */
   tst_node_t *tst_daccess = NULL; /* TST used by the direct access system.   */
+  tst_key_t  *tst_keys;           /* sorted keys used to build tst_word.     */
+  long        nb_keys, nb_uniq;   /* number of keys, of distinct keys.       */
+  long       *positions;          /* word indexes of the sorted keys.        */
+  long        last;               /* end of a group of identical keys.       */
+
+  sa_t *substring_sa       = NULL; /* suffix array used by the substring     *
+                                    | search, built when first needed.       */
+  int   substring_sa_built = 0;    /* 1 once the building has been tried.    */
+
+  fuzzy_index_t *fuzzy_index       = NULL; /* index used by the fuzzy      *
+                                            | search, built when first     *
+                                            | needed.                      */
+  int            fuzzy_index_built = 0;    /* 1 once the building has been *
+                                            | tried.                       */
 
   long  page;     /* Step for the vertical cursor moves.                     */
   char *word;     /* Temporary variable to work on words.                    */
@@ -9201,10 +10025,16 @@ main(int argc, char *argv[])
 
   long cols_max_size = 0; /* Same as above for the columns widths            */
 
+  char *expanded_word;      /* buffer receiving the expanded words.          */
+  long  expanded_word_size; /* allocated size of this buffer.                */
+
   long col_index = 0; /* Index of the current column when reading words,     *
                        | used  in column mode.                               */
 
   long cols_number = 0; /* Number of columns in column mode.                 */
+  long cols_size   = 0; /* Number of columns allocated in the arrays above.  */
+
+  long word_a_size; /* Number of words allocated in word_a.                  */
 
   char *pre_selection_index = NULL; /* pattern used to set the initial       *
                                      | cursor position.                      */
@@ -9232,6 +10062,8 @@ main(int argc, char *argv[])
   ll_t *line_delims_list   = NULL;
   ll_t *zapped_glyphs_list = NULL;
 
+  glyph_class_t *glyph_classes; /* Compiled form of the three lists above. */
+
   char utf8_buffer[5]; /* buffer to store the bytes of a UTF-8 glyph         *
                         | (4 chars max).                                     */
   unsigned char is_last;
@@ -10749,10 +11581,6 @@ main(int argc, char *argv[])
   else /* -n was not used. Set win.asked_max_lines to its default value. */
     win.asked_max_lines = win.max_lines;
 
-  /* Allocate the memory for our words structures. */
-  /* """"""""""""""""""""""""""""""""""""""""""""" */
-  word_a = xmalloc(WORDSCHUNK * sizeof(word_t));
-
   /* Fill an array of word_t elements obtained from stdin. */
   /* """"""""""""""""""""""""""""""""""""""""""""""""""""" */
   tab_real_max_size = 0;
@@ -10881,6 +11709,34 @@ main(int argc, char *argv[])
     }
   }
 
+  /* Compile the three glyphs lists above in a structure allowing to */
+  /* classify each glyph read with a single lookup.                  */
+  /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+  glyph_classes = glyph_class_new();
+  glyph_class_add_list(glyph_classes, word_delims_list, WORD_DELIM_GLYPH);
+  glyph_class_add_list(glyph_classes, line_delims_list, LINE_DELIM_GLYPH);
+  glyph_class_add_list(glyph_classes, zapped_glyphs_list, ZAPPED_GLYPH);
+
+  /* Mark the bytes which cannot be part of the runs of plain ASCII */
+  /* characters copied at once by read_word.                        */
+  /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+  glyph_class_add(glyph_classes, "\\", SPECIAL_GLYPH);
+  glyph_class_add(glyph_classes, "\x1b", SPECIAL_GLYPH);
+
+  if (!misc.ignore_quotes)
+  {
+    glyph_class_add(glyph_classes, "\"", SPECIAL_GLYPH);
+    glyph_class_add(glyph_classes, "'", SPECIAL_GLYPH);
+  }
+
+  glyph_classes->byte_class[0] |= SPECIAL_GLYPH;
+  for (wi = 0x80; wi < 0x100; wi++)
+    glyph_classes->byte_class[wi] |= SPECIAL_GLYPH;
+
+  glyph_class_prepare_span(glyph_classes,
+                           WORD_DELIM_GLYPH | LINE_DELIM_GLYPH | ZAPPED_GLYPH
+                             | SPECIAL_GLYPH);
+
   /* Initialize the first chunks of the arrays which will contain the */
   /* maximum length of each column in column mode.                    */
   /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
@@ -10888,10 +11744,11 @@ main(int argc, char *argv[])
   {
     long ci; /* Column index. */
 
-    col_real_max_size = xmalloc(COLSCHUNK * sizeof(long));
-    col_max_size      = xmalloc(COLSCHUNK * sizeof(long));
+    cols_size         = COLSCHUNK;
+    col_real_max_size = xmalloc(cols_size * sizeof(long));
+    col_max_size      = xmalloc(cols_size * sizeof(long));
 
-    for (ci = 0; ci < COLSCHUNK; ci++)
+    for (ci = 0; ci < cols_size; ci++)
       col_real_max_size[ci] = col_max_size[ci] = 0;
 
     col_index = cols_number = 0;
@@ -11325,10 +12182,33 @@ main(int argc, char *argv[])
   /* - The -R is taken into account                               */
   /* - The first part of the -C option is done                    */
   /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
-  while ((word = read_word(input_file,
-                           word_delims_list,
-                           line_delims_list,
-                           zapped_glyphs_list,
+  input_buf  = in_buf_new(input_file);
+  word_arena = arena_new(ARENACHUNK);
+
+  /* Allocate the memory for our words structures. The size of a memory */
+  /* mapped input gives a hint of the number of words to expect.        */
+  /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+  if (input_buf->mapped)
+    word_a_size = (long)((input_buf->end - input_buf->pos) / 16) + WORDSCHUNK;
+  else
+    word_a_size = WORDSCHUNK;
+
+  if (word_a_size > limits.words + 1)
+    word_a_size = limits.words + 1;
+
+  word_a      = xmalloc(word_a_size * sizeof(word_t));
+  word_cold_a = xmalloc(word_a_size * sizeof(word_cold_t));
+
+  /* A piped input may be slow to come, give some feedback on the */
+  /* terminal if this is the case.                                */
+  /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+  if (!input_buf->mapped && is_in_foreground_process_group())
+    progress_tty = fopen("/dev/tty", "w");
+
+  disp_reading_progress(0);
+
+  while ((word = read_word(input_buf,
+                           glyph_classes,
                            utf8_buffer,
                            &is_last,
                            &toggles,
@@ -11344,11 +12224,14 @@ main(int argc, char *argv[])
     int           row_inc_matched = 0;
     ll_node_t    *node;
 
+    disp_reading_progress(count);
+
     if (*word == '\0')
       continue;
 
     if (utf8_strlen(word) > limits.word_length)
     {
+      disp_reading_progress(-1);
       fprintf(stderr,
               "The length of a word exceeds the word length limit of "
               "%ld glyphs.\n",
@@ -11370,9 +12253,7 @@ main(int argc, char *argv[])
         tmp = xstrdup(word);
         if (replace(word, (sed_t *)(node->data)))
         {
-
-          free(word);
-          word = xstrdup(word_buffer);
+          word = arena_strdup(word_arena, word_buffer);
 
           if (((sed_t *)(node->data))->stop)
             break;
@@ -11630,6 +12511,7 @@ main(int argc, char *argv[])
           /* ''''''''''''''''' */
           if (col_index == limits.cols + 1)
           {
+            disp_reading_progress(-1);
             fprintf(stderr,
                     "The number of columns exceeds the %ld column limit.\n",
                     limits.cols);
@@ -11640,25 +12522,25 @@ main(int argc, char *argv[])
           cols_number++;
 
           /* Look if we need to enlarge the arrays indexed by the */
-          /* number of columns.                                   */
+          /* number of columns. Their size is doubled each time.  */
           /* '''''''''''''''''''''''''''''''''''''''''''''''''''' */
-          if (cols_number % COLSCHUNK == 0)
+          if (cols_number == cols_size)
           {
             long ci; /* column index */
 
+            cols_size *= 2;
+
             col_real_max_size = xrealloc(col_real_max_size,
-                                         (cols_number + COLSCHUNK)
-                                           * sizeof(long));
+                                         cols_size * sizeof(long));
 
-            col_max_size = xrealloc(col_max_size,
-                                    (cols_number + COLSCHUNK) * sizeof(long));
+            col_max_size = xrealloc(col_max_size, cols_size * sizeof(long));
 
             /* Initialize the max size for the new columns. */
             /* '''''''''''''''''''''''''''''''''''''''''''' */
-            for (ci = 0; ci < COLSCHUNK; ci++)
+            for (ci = cols_number; ci < cols_size; ci++)
             {
-              col_real_max_size[cols_number + ci] = 0;
-              col_max_size[cols_number + ci]      = 0;
+              col_real_max_size[ci] = 0;
+              col_max_size[ci]      = 0;
             }
           }
         }
@@ -11735,26 +12617,20 @@ main(int argc, char *argv[])
       }
     }
 
-    /* Initialize the alignment information of each column to be 'left'. */
-    /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
-    col_attrs = xmalloc((cols_number + 1) * sizeof(attrib_t *));
-    for (long ci = 0; ci < cols_number; ci++)
-      col_attrs[ci] = NULL;
-
     /* Store some known values in the current word's structure. */
     /* """""""""""""""""""""""""""""""""""""""""""""""""""""""" */
     word_a[count].start = word_a[count].end = 0;
 
-    word_a[count].str           = word;
     word_a[count].is_selectable = selectable;
-
     word_a[count].special_level = special_level;
     word_a[count].is_matching   = 0;
     word_a[count].is_numbered   = 0;
-    word_a[count].tag_order     = 0;
-    word_a[count].tag_id        = 0;
-    word_a[count].iattr         = NULL;
-    word_a[count].offset        = 0;
+
+    word_cold_a[count].str       = word;
+    word_cold_a[count].tag_order = 0;
+    word_cold_a[count].tag_id    = 0;
+    word_cold_a[count].iattr     = NULL;
+    word_cold_a[count].offset    = 0;
 
     if (win.col_mode || win.line_mode || win.tab_mode)
     {
@@ -11774,6 +12650,7 @@ main(int argc, char *argv[])
     /* """""""""""""""" */
     if (count + 1 > limits.words)
     {
+      disp_reading_progress(-1);
       fprintf(stderr,
               "The number of words read exceeds the %ld word limit.\n",
               limits.words);
@@ -11783,9 +12660,39 @@ main(int argc, char *argv[])
 
     count++;
 
-    if (count % WORDSCHUNK == 0)
-      word_a = xrealloc(word_a, (count + WORDSCHUNK) * sizeof(word_t));
+    /* Double the size of word_a when full without going beyond */
+    /* what the word limit allows.                              */
+    /* """""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+    if (count == word_a_size)
+    {
+      word_a_size *= 2;
+      if (word_a_size > limits.words + 1)
+        word_a_size = limits.words + 1;
+
+      word_a      = xrealloc(word_a, word_a_size * sizeof(word_t));
+      word_cold_a = xrealloc(word_cold_a, word_a_size * sizeof(word_cold_t));
+    }
+  }
+
+  if (!input_buf->mapped)
+  {
+    in_buf_free(input_buf);
+    input_buf = NULL;
   }
+  glyph_class_free(glyph_classes);
+
+  if (progress_tty != NULL)
+  {
+    disp_reading_progress(-1);
+    fclose(progress_tty);
+    progress_tty = NULL;
+  }
+
+  /* Initialize the alignment information of each column to be 'left'. */
+  /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+  col_attrs = xmalloc((cols_number + 1) * sizeof(attrib_t *));
+  for (long ci = 0; ci < cols_number; ci++)
+    col_attrs[ci] = NULL;
 
   /* Early exit if there is no input or if no word is selected. */
   /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
@@ -11815,18 +12722,21 @@ main(int argc, char *argv[])
   /* - Insert the word in a TST (Ternary Search Tree) index to facilitate   */
   /*   word search (each node pf the TST will contain an UTF-8 glyph).      */
   /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
-  col_index = 0;
+  col_index          = 0;
+  expanded_word      = NULL;
+  expanded_word_size = 0;
+
   for (wi = 0; wi < count; wi++)
   {
-    char    *unaltered_word;
-    long     size;
-    long     word_len;
-    wchar_t *tmpw;
-    word_t  *word;
-    long     s;
-    long     len;
-    char    *expanded_word;
-    long     i;
+    char        *unaltered_word;
+    long         size;
+    long         word_len;
+    word_t      *word;
+    word_cold_t *cold;
+    long         s;
+    long         nb_glyphs;
+    long         len;
+    long         i;
 
     /* If the column section argument is set, then adjust the final        */
     /* selectable attribute  according to the already set words and column */
@@ -11863,6 +12773,7 @@ main(int argc, char *argv[])
     }
 
     word = &word_a[wi];
+    cold = &word_cold_a[wi];
 
     /* Make sure that daccess.length >= daccess.size */
     /* with DA_TYPE_POS.                             */
@@ -11903,10 +12814,10 @@ main(int argc, char *argv[])
         int   may_number;
         long  wlen;
 
-        wlen = strlen(word->str) + 4 + daccess.length;
-        tmp  = xmalloc(wlen);
+        wlen = strlen(cold->str) + 4 + daccess.length;
+        tmp  = arena_alloc(word_arena, wlen);
 
-        if (!my_isempty((unsigned char *)word->str))
+        if (!my_isempty((unsigned char *)cold->str))
         {
           *word_pos = wi;
 
@@ -11924,12 +12835,12 @@ main(int argc, char *argv[])
           else
           {
             if (daccess_up != NULL
-                && !!regexec(&daccess_up_re, word->str, (int)0, NULL, 0) == 0)
+                && !!regexec(&daccess_up_re, cold->str, (int)0, NULL, 0) == 0)
               may_number = 0;
             else
             {
               if (daccess_np != NULL
-                  && !!regexec(&daccess_np_re, word->str, (int)0, NULL, 0) == 0)
+                  && !!regexec(&daccess_np_re, cold->str, (int)0, NULL, 0) == 0)
                 may_number = 1;
               else
                 may_number = daccess.def_number;
@@ -11943,7 +12854,7 @@ main(int argc, char *argv[])
             if ((daccess.mode & DA_TYPE_POS) && !word->is_numbered
                 && daccess.size > 0
                 && (daccess.offset + daccess.size + daccess.ignore)
-                     <= utf8_strlen(word->str))
+                     <= utf8_strlen(cold->str))
             {
               long  selector_value;  /* numerical value of the         *
                                       | extracted selector.            */
@@ -11952,22 +12863,22 @@ main(int argc, char *argv[])
               char *ptr;             /* points just after the selector *
                                       | to extract.                    */
               long  plus_offset;     /* points to the first occurrence *
-                                      | of a number in word->str after *
+                                      | of a number in cold->str after *
                                       | the offset given.              */
 
-              selector_offset = utf8_offset(word->str, daccess.offset);
+              selector_offset = utf8_offset(cold->str, daccess.offset);
 
               if (daccess.plus)
               {
-                plus_offset = strcspn(word->str + selector_offset,
+                plus_offset = strcspn(cold->str + selector_offset,
                                       "0123456789");
 
                 if (plus_offset + daccess.size + daccess.ignore
-                    <= strlen(word->str))
+                    <= strlen(cold->str))
                   selector_offset += plus_offset;
               }
 
-              ptr      = word->str + selector_offset;
+              ptr      = cold->str + selector_offset;
               selector = xstrndup(ptr, daccess.size);
 
               /* read the embedded number and, if correct, format */
@@ -11998,19 +12909,19 @@ main(int argc, char *argv[])
                   /* h:c is present cut the leading characters */
                   /* before the selector.                      */
                   /* ''''''''''''''''''''''''''''''''''''''''' */
-                  memmove(word->str, ptr, strlen(ptr) + 1);
+                  memmove(cold->str, ptr, strlen(ptr) + 1);
                 else if (daccess.head == 't')
                 {
                   /* h:t is present trim the leading characters   */
                   /* before the selector if they are ' ' or '\t'. */
                   /* '''''''''''''''''''''''''''''''''''''''''''' */
-                  char *p = word->str;
+                  char *p = cold->str;
 
                   while (p != ptr && (*p == ' ' || *p == '\t'))
                     p++;
 
                   if (p == ptr)
-                    memmove(word->str, ptr, strlen(ptr) + 1);
+                    memmove(cold->str, ptr, strlen(ptr) + 1);
                 }
 
                 ltrim(selector, " ");
@@ -12087,12 +12998,9 @@ main(int argc, char *argv[])
 
         if (daccess.length > 0)
         {
-          my_strcpy(tmp + daccess.flength, word->str);
-          free(word->str);
-          word->str = tmp;
+          my_strcpy(tmp + daccess.flength, cold->str);
+          cold->str = tmp;
         }
-        else
-          free(tmp);
       }
       else
       {
@@ -12100,12 +13008,12 @@ main(int argc, char *argv[])
         /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
         if (daccess.padding == 'a')
         {
-          char *tmp = xmalloc(strlen(word->str) + 4 + daccess.length);
+          char *tmp = arena_alloc(word_arena,
+                                  strlen(cold->str) + 4 + daccess.length);
           for (i = 0; i < daccess.flength; i++)
             tmp[i] = ' ';
-          my_strcpy(tmp + daccess.flength, word->str);
-          free(word->str);
-          word->str = tmp;
+          my_strcpy(tmp + daccess.flength, cold->str);
+          cold->str = tmp;
         }
       }
     }
@@ -12115,9 +13023,10 @@ main(int argc, char *argv[])
       daccess.length = 0;
     }
 
-    /* Save the original word. */
-    /* """"""""""""""""""""""" */
-    unaltered_word = xstrdup(word->str);
+    /* Remember the original word. The modifications below store the */
+    /* modified word elsewhere in the arena and leave it untouched.  */
+    /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+    unaltered_word = cold->str;
 
     /* Possibly modify the word according to -S/-I/-E arguments. */
     /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""" */
@@ -12133,17 +13042,15 @@ main(int argc, char *argv[])
 
         while (node != NULL)
         {
-          tmp = xstrndup(word->str, daccess.flength);
-          if (replace(word->str + daccess.flength, (sed_t *)(node->data)))
+          tmp = xstrndup(cold->str, daccess.flength);
+          if (replace(cold->str + daccess.flength, (sed_t *)(node->data)))
           {
-
-            free(word->str);
             memmove(word_buffer + daccess.flength,
                     word_buffer,
                     strlen(word_buffer) + 1);
             memmove(word_buffer, tmp, daccess.flength);
 
-            word->str = xstrdup(word_buffer);
+            cold->str = arena_strdup(word_arena, word_buffer);
 
             if (((sed_t *)(node->data))->stop)
               break;
@@ -12173,17 +13080,15 @@ main(int argc, char *argv[])
 
         while (node != NULL)
         {
-          tmp = xstrndup(word->str, daccess.flength);
-          if (replace(word->str + daccess.flength, (sed_t *)(node->data)))
+          tmp = xstrndup(cold->str, daccess.flength);
+          if (replace(cold->str + daccess.flength, (sed_t *)(node->data)))
           {
-
-            free(word->str);
             memmove(word_buffer + daccess.flength,
                     word_buffer,
                     strlen(word_buffer) + 1);
             memmove(word_buffer, tmp, daccess.flength);
 
-            word->str = xstrdup(word_buffer);
+            cold->str = arena_strdup(word_arena, word_buffer);
 
             if (((sed_t *)(node->data))->stop)
               break;
@@ -12206,30 +13111,35 @@ main(int argc, char *argv[])
       else
         len = 0;
 
-      if (*(word->str + len) == '\0')
+      if (*(cold->str + len) == '\0')
         exit(EXIT_FAILURE);
     }
 
     /* Alter the word just read be replacing special chars  by their */
     /* escaped equivalents.                                          */
     /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
-    word_len = strlen(word->str);
+    word_len = strlen(cold->str);
 
-    expanded_word = xmalloc(5 * word_len + 1);
-    len = expand(word->str, expanded_word, &langinfo, &toggles, &misc);
+    /* The expansion buffer is shared by all the words and only */
+    /* enlarged when a longer word needs it.                    */
+    /* """""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+    if (5 * word_len + 1 > expanded_word_size)
+    {
+      expanded_word_size = 5 * word_len + 1;
+      expanded_word      = xrealloc(expanded_word, expanded_word_size);
+    }
+
+    len = expand(cold->str, expanded_word, &langinfo, &toggles, &misc);
 
     /* Update it if needed. */
     /* '''''''''''''''''''' */
-    if (strcmp(expanded_word, word->str) != 0)
+    if (strcmp(expanded_word, cold->str) != 0)
     {
-      word_len = len;
-      free(word->str);
-      word->str = xstrdup(expanded_word);
+      word_len  = len;
+      cold->str = arena_strdup(word_arena, expanded_word);
     }
 
-    free(expanded_word);
-
-    word->len_mb = utf8_strlen(word->str);
+    cold->len_mb = utf8_strlen(cold->str);
 
     if (win.col_mode)
     {
@@ -12246,9 +13156,7 @@ main(int argc, char *argv[])
           cols_real_max_size = s;
       }
 
-      s = (long)mbstowcs(NULL, word->str, 0);
-      s = my_wcswidth((tmpw = utf8_strtowcs(word->str)), s);
-      free(tmpw);
+      s = get_str_width(cold->str, &nb_glyphs);
 
       if (s > col_max_size[col_index])
       {
@@ -12276,13 +13184,8 @@ main(int argc, char *argv[])
 
       /* Store the new max word width. */
       /* """"""""""""""""""""""""""""" */
-      size = (long)mbstowcs(NULL, word->str, 0);
-
-      if ((size = my_wcswidth((tmpw = utf8_strtowcs(word->str)), size))
-          > tab_max_size)
+      if ((size = get_str_width(cold->str, &nb_glyphs)) > tab_max_size)
         tab_max_size = size;
-
-      free(tmpw);
     }
     else if (word_real_max_size < word_len)
       /* Update the size of the longest expanded word. */
@@ -12297,21 +13200,16 @@ main(int argc, char *argv[])
     /* Record the length of the word in bytes. This information will be */
     /* used if the -k option (keep spaces ) is not set.                 */
     /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
-    word->len = strlen(word->str);
+    cold->len = strlen(cold->str);
 
     /* Save the non modified word in .orig if it has been altered. */
     /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
-    if ((strcmp(word->str, unaltered_word) != 0)
+    if ((strcmp(cold->str, unaltered_word) != 0)
         && ((word->is_selectable && include_visual_only)
             || (!word->is_selectable && exclude_visual_only)))
-    {
-      word->orig = unaltered_word;
-    }
+      cold->orig = unaltered_word;
     else
-    {
-      word->orig = NULL;
-      free(unaltered_word);
-    }
+      cold->orig = NULL;
 
     if (win.col_mode)
     {
@@ -12322,6 +13220,8 @@ main(int argc, char *argv[])
     }
   }
 
+  free(expanded_word);
+
   /* Set the minimum width of a column (-w and -t or -c option). */
   /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
   if (win.wide)
@@ -12365,7 +13265,7 @@ main(int argc, char *argv[])
         else
           len = 0;
 
-        if (!my_isempty((unsigned char *)(word_a[wi + offset].str + len)))
+        if (!my_isempty((unsigned char *)(word_cold_a[wi + offset].str + len)))
           break;
 
         /* Keep non selectable empty words to allow special effects. */
@@ -12378,7 +13278,10 @@ main(int argc, char *argv[])
       }
 
       if (offset > 0)
-        word_a[wi] = word_a[wi + offset];
+      {
+        word_a[wi]      = word_a[wi + offset];
+        word_cold_a[wi] = word_cold_a[wi + offset];
+      }
     }
     count -= offset;
   }
@@ -12386,6 +13289,13 @@ main(int argc, char *argv[])
   if (count == 0)
     exit(EXIT_FAILURE);
 
+  /* No more words will be added, give back the unused part of word_a */
+  /* but keep room for the NULL word which will mark its end.         */
+  /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+  word_a_size = count + 1;
+  word_a      = xrealloc(word_a, word_a_size * sizeof(word_t));
+  word_cold_a = xrealloc(word_cold_a, word_a_size * sizeof(word_cold_t));
+
   /* Allocate the space for the satellites arrays. */
   /* """"""""""""""""""""""""""""""""""""""""""""" */
   line_nb_of_word_a     = xmalloc(count * sizeof(long));
@@ -12427,8 +13337,7 @@ main(int argc, char *argv[])
     for (wi = 0; wi < count; wi++)
     {
       long        s1, s2;
-      long        word_width;
-      wchar_t    *w;
+      long        nb_glyphs;
       regex_t     re;
       ll_node_t  *node;
       interval_t *interval;
@@ -12453,7 +13362,11 @@ main(int argc, char *argv[])
         while (node) /* For each RE in the list. */
         {
           re = *(regex_t *)(node->data);
-          if (regexec(&re, word_a[wi].str + daccess.flength, (int)0, NULL, 0)
+          if (regexec(&re,
+                      word_cold_a[wi].str + daccess.flength,
+                      (int)0,
+                      NULL,
+                      0)
               == 0)
           {
             int already_aligned = 0;
@@ -12524,7 +13437,11 @@ main(int argc, char *argv[])
           while (regex_node)
           {
             re = *(regex_t *)(regex_node->data);
-            if (regexec(&re, word_a[wi].str + daccess.flength, (int)0, NULL, 0)
+            if (regexec(&re,
+                        word_cold_a[wi].str + daccess.flength,
+                        (int)0,
+                        NULL,
+                        0)
                 == 0)
             {
               /* We have a match. */
@@ -12566,10 +13483,8 @@ main(int argc, char *argv[])
         }
       }
 
-      s1         = (long)strlen(word_a[wi].str);
-      word_width = mbstowcs(NULL, word_a[wi].str, 0);
-      s2         = my_wcswidth((w = utf8_strtowcs(word_a[wi].str)), word_width);
-      free(w);
+      s1 = (long)strlen(word_cold_a[wi].str);
+      s2 = get_str_width(word_cold_a[wi].str, &nb_glyphs);
 
       /* Use the al_delim (0x05) character as a placeholder to preserve  */
       /* the internal spaces of the word if there are any.               */
@@ -12578,12 +13493,13 @@ main(int argc, char *argv[])
       /* the input stream.                                               */
       /* This placeholder will be removed during the alignment phase.    */
       /*"""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
-      temp = xcalloc(1, col_real_max_size[col_index] + s1 - s2 + 1);
+      temp = arena_calloc(word_arena,
+                          1,
+                          col_real_max_size[col_index] + s1 - s2 + 1);
       memset(temp, al_delim, col_max_size[col_index] + s1 - s2);
-      memcpy(temp, word_a[wi].str, s1);
+      memcpy(temp, word_cold_a[wi].str, s1);
       temp[col_real_max_size[col_index] + s1 - s2] = '\0';
-      free(word_a[wi].str);
-      word_a[wi].str = temp;
+      word_cold_a[wi].str = temp;
 
       if (word_a[wi].is_last)
         col_index = 0;
@@ -12607,69 +13523,74 @@ main(int argc, char *argv[])
 
     for (wi = 0; wi < count; wi++)
     {
-      long     s1, s2;
-      long     word_width;
-      wchar_t *w;
+      long s1, s2;
+      long nb_glyphs;
 
-      s1         = (long)strlen(word_a[wi].str);
-      word_width = mbstowcs(NULL, word_a[wi].str, 0);
-      s2         = my_wcswidth((w = utf8_strtowcs(word_a[wi].str)), word_width);
-      free(w);
-      temp = xcalloc(1, tab_real_max_size + s1 - s2 + 1);
+      s1 = (long)strlen(word_cold_a[wi].str);
+      s2 = get_str_width(word_cold_a[wi].str, &nb_glyphs);
+      temp = arena_calloc(word_arena, 1, tab_real_max_size + s1 - s2 + 1);
       memset(temp, ' ', tab_max_size + s1 - s2);
-      memcpy(temp, word_a[wi].str, s1);
+      memcpy(temp, word_cold_a[wi].str, s1);
       temp[tab_real_max_size + s1 - s2] = '\0';
-      free(word_a[wi].str);
-      word_a[wi].str = temp;
+      word_cold_a[wi].str = temp;
     }
   }
 
   /* Fifth pass: transforms the remaining SOFT_EXCLUDE_MARKs with */
-  /* EXCLUDE_MARKs.                                               */
+  /* EXCLUDE_MARKs and collects the keys of the search TST.       */
   /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+  tst_keys = xmalloc(count * sizeof(tst_key_t));
+  nb_keys  = 0;
+
   for (wi = 0; wi < count; wi++)
   {
-    long    *data;
-    wchar_t *w;
-    ll_t    *list;
-
     if (word_a[wi].is_selectable == SOFT_EXCLUDE_MARK)
       word_a[wi].is_selectable = EXCLUDE_MARK;
 
-    /* If the word is selectable insert it in the TST tree */
-    /* with its associated index in the input stream.      */
-    /* """"""""""""""""""""""""""""""""""""""""""""""""""" */
+    /* If the word is selectable remember it with its associated */
+    /* index in the input stream.                                */
+    /* Note that the direct access selector,if any, is not       */
+    /* stored.                                                   */
+    /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""" */
     if (word_a[wi].is_selectable)
     {
-      data  = xmalloc(sizeof(long));
-      *data = wi;
-
-      /* Create a wide characters string from the word screen */
-      /* representation to be able to store in in the TST.    */
-      /* Note that the direct access selector,if any, is not  */
-      /* stored.                                              */
-      /* """""""""""""""""""""""""""""""""""""""""""""""""""" */
       if (word_a[wi].is_numbered)
-        w = utf8_strtowcs(word_a[wi].str + daccess.flength);
+        tst_keys[nb_keys].str = word_cold_a[wi].str + daccess.flength;
       else
-        w = utf8_strtowcs(word_a[wi].str);
+        tst_keys[nb_keys].str = word_cold_a[wi].str;
 
-      /* If we didn't already encounter this word, then create a new */
-      /* entry in the TST for it and store its index in its list.    */
-      /* Otherwise, add its index in its index list.                 */
-      /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
-      if (tst_word && (list = tst_search(tst_word, w)) != NULL)
-        ll_append(list, data);
-      else
-      {
-        list = ll_new();
-        ll_append(list, data);
-        tst_word = tst_insert(tst_word, w, list);
-      }
-      free(w);
+      tst_keys[nb_keys++].pos = wi;
     }
   }
 
+  /* Sort the keys and merge the identical ones, each unique key gets */
+  /* the posting list of the indexes of its occurrences in the input  */
+  /* stream.                                                          */
+  /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+  qsort(tst_keys, nb_keys, sizeof(tst_key_t), tst_key_cmp);
+
+  positions = xmalloc((nb_keys + 1) * sizeof(long));
+  for (index = 0; index < nb_keys; index++)
+    positions[index] = tst_keys[index].pos;
+
+  for (index = 0, nb_uniq = 0; index < nb_keys; index = last)
+  {
+    last = index + 1;
+    while (last < nb_keys
+           && strcmp(tst_keys[last].str, tst_keys[index].str) == 0)
+      last++;
+
+    tst_keys[nb_uniq].str    = tst_keys[index].str;
+    tst_keys[nb_uniq++].data = posting_new(positions + index, last - index);
+  }
+  free(positions);
+
+  /* Build a balanced TST from the wide characters version of the */
+  /* unique keys.                                                 */
+  /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+  tst_word = tst_build(tst_word, tst_keys, nb_uniq);
+  free(tst_keys);
+
   /* Sixth pass: Apply alignment rules in column modes.                    */
   /* The column alignments, based on regular expressions, have already     */
   /* been processed in the fourth pass which converted this information    */
@@ -12739,7 +13660,7 @@ main(int argc, char *argv[])
       else
         alignment = default_alignment;
 
-      str  = xstrdup(word_a[wi].str + daccess.flength);
+      str  = xstrdup(word_cold_a[wi].str + daccess.flength);
       tstr = xstrdup(str);
 
       rtrim(tstr, "\x05", 0);
@@ -12876,7 +13797,7 @@ main(int argc, char *argv[])
                 /* column alignments have precedence.            */
                 /* ''''''''''''''''''''''''''''''''''''''''''''' */
                 if (aligned_a[col_index - (wi - j)] == 'N')
-                  align_word(&word_a[j],
+                  align_word(&word_cold_a[j],
                              alignment_a[i],
                              daccess.flength,
                              al_delim);
@@ -12899,7 +13820,7 @@ main(int argc, char *argv[])
 
       /* Do the alignment. */
       /* """"""""""""""""" */
-      align_word(&word_a[wi], alignment, daccess.flength, al_delim);
+      align_word(&word_cold_a[wi], alignment, daccess.flength, al_delim);
 
       /* Adjusts things before a row change. */
       /* """"""""""""""""""""""""""""""""""" */
@@ -12918,7 +13839,7 @@ main(int argc, char *argv[])
           /* now that the row is fully processed.                     */
           /* """""""""""""""""""""""""""""""""""""""""""""""""""""""" */
           if (wi - i >= 0)
-            strrep(word_a[wi - i].str + daccess.flength, al_delim, ' ');
+            strrep(word_cold_a[wi - i].str + daccess.flength, al_delim, ' ');
         }
 
         col_index     = 0; /* Restart the columns counter. */
@@ -12952,7 +13873,7 @@ main(int argc, char *argv[])
 
       for (wi = 0; wi < count; wi++)
       {
-        if (word_a[wi].iattr != NULL)
+        if (word_cold_a[wi].iattr != NULL)
           continue;
 
         if (at_row_interval_list != NULL)
@@ -12970,7 +13891,7 @@ main(int argc, char *argv[])
               interval = node->data;
               if (row_index >= interval->low && row_index <= interval->high)
               {
-                word_a[wi].iattr = attr;
+                word_cold_a[wi].iattr = attr;
                 goto early_row_exit;
               }
               node = node->next;
@@ -12994,15 +13915,15 @@ main(int argc, char *argv[])
               interval = node->data;
               if (col_index >= interval->low && col_index <= interval->high)
               {
-                if (word_a[wi].iattr == NULL || toggles.cols_first)
+                if (word_cold_a[wi].iattr == NULL || toggles.cols_first)
                 {
                   if (col_attrs[col_index] == NULL)
                   {
-                    word_a[wi].iattr     = attr;
-                    col_attrs[col_index] = attr;
+                    word_cold_a[wi].iattr = attr;
+                    col_attrs[col_index]  = attr;
                   }
                   else
-                    word_a[wi].iattr = col_attrs[col_index];
+                    word_cold_a[wi].iattr = col_attrs[col_index];
 
                   goto early_col_exit;
                 }
@@ -13027,7 +13948,7 @@ main(int argc, char *argv[])
             {
               re = *(regex_t *)(node->data);
               if (regexec(&re,
-                          word_a[wi].str + daccess.flength,
+                          word_cold_a[wi].str + daccess.flength,
                           (int)0,
                           NULL,
                           0)
@@ -13040,9 +13961,9 @@ main(int argc, char *argv[])
                 while (wi < count)
                 {
                   if (toggles.cols_first && col_attrs[col_index] != NULL)
-                    word_a[wi].iattr = col_attrs[col_index];
+                    word_cold_a[wi].iattr = col_attrs[col_index];
                   else
-                    word_a[wi].iattr = attr;
+                    word_cold_a[wi].iattr = attr;
 
                   col_index++;
 
@@ -13074,7 +13995,21 @@ main(int argc, char *argv[])
 
   /* The word after the last one is set to NULL. */
   /* """"""""""""""""""""""""""""""""""""""""""" */
-  word_a[count].str = NULL;
+  word_cold_a[count].str = NULL;
+
+  /* The words will no longer change, we can now determine the number   */
+  /* of glyphs and the number of screen positions taken by each of them */
+  /* to spare these computations each time the lines are rebuilt.       */
+  /* Note: mbstowcs will always succeed here as word_cold_a[wi].str has */
+  /*       already been utf8_validated/repaired.                        */
+  /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+  for (wi = 0; wi < count; wi++)
+  {
+    long nb_glyphs;
+
+    word_a[wi].width     = get_str_width(word_cold_a[wi].str, &nb_glyphs);
+    word_a[wi].nb_glyphs = nb_glyphs;
+  }
 
   /* We can now allocate the space for our tmp_word work variable        */
   /* augmented by the number of tabulation columns or the size of the    */
@@ -13120,13 +14055,27 @@ main(int argc, char *argv[])
     /* bytes composing the direct access prefix.                      */
     /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
     if (daccess.padding == 'i')
-      word_a[wi].bitmap = xcalloc(1, (word_a[wi].mb) / CHAR_BIT + 1);
+      word_cold_a[wi].bitmap = arena_calloc(word_arena,
+                                       1,
+                                       (word_a[wi].mb) / CHAR_BIT + 1);
     else
-      word_a[wi].bitmap = xcalloc(1,
-                                  (word_a[wi].mb - daccess.flength) / CHAR_BIT
-                                    + 1);
+      word_cold_a[wi].bitmap = arena_calloc(word_arena,
+                                       1,
+                                       (word_a[wi].mb - daccess.flength)
+                                           / CHAR_BIT
+                                         + 1);
+
+    word_cold_a[wi].bitmap_gen = 0;
+
+    word_cold_a[wi].fold = fold_word(word_cold_a[wi].str + daccess.flength
+                                     + word_cold_a[wi].offset);
   }
 
+  /* The matching words are collected in this bit array before */
+  /* being stored in matching_words_da.                        */
+  /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+  matching_words_bits = xcalloc(1, count / CHAR_BIT + 1);
+
   /* Find the first selectable word (if any) in the input stream. */
   /* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
   first_selectable = 0;
@@ -13174,31 +14123,27 @@ main(int argc, char *argv[])
         if (!word_a[index].is_selectable)
           continue;
 
-        if (word_a[index].orig != NULL)
-          word = word_a[index].orig;
+        if (word_cold_a[index].orig != NULL)
+          word = word_cold_a[index].orig;
         else
-          word = word_a[index].str;
+          word = word_cold_a[index].str;
 
         if (regexec(&re, word, (int)0, NULL, 0) == 0)
         {
-          long target;
-
           if (!found)
           {
             found   = 1;
             current = index;
           }
 
-          /* Insert the index in the search array. */
-          /* """"""""""""""""""""""""""""""""""""" */
-          target = get_sorted_array_target_pos(matching_words_da,
-                                               BUF_LEN(matching_words_da),
-                                               index);
-          if (target >= 0)
-            BUF_INSERT(matching_words_da, target, index);
+          /* Add the index to the search set. */
+          /* """""""""""""""""""""""""""""""" */
+          BIT_ON(matching_words_bits, index);
         }
       }
 
+      collect_matching_words();
+
       if (!found)
         current = first_selectable;
     }
@@ -13209,29 +14154,22 @@ main(int argc, char *argv[])
     /* """"""""""""""""""""""""""" */
     wchar_t *w;
 
-    ll_t      *list;
-    ll_node_t *node;
+    posting_t     *posting;
+    posting_iter_t it;
+    long           pos;
 
-    list = tst_search(tst_word, w = utf8_strtowcs(pre_selection_index + 1));
-    if (list != NULL)
+    posting = tst_search(tst_word, w = utf8_strtowcs(pre_selection_index + 1));
+    if (posting != NULL)
     {
-      long target;
+      current = posting->first;
 
-      node    = list->head;
-      current = *(long *)(node->data);
-
-      while (node)
-      {
-        /* Insert the index in the search array. */
-        /* """"""""""""""""""""""""""""""""""""" */
-        target = get_sorted_array_target_pos(matching_words_da,
-                                             BUF_LEN(matching_words_da),
-                                             *(long *)(node->data));
-        if (target >= 0)
-          BUF_INSERT(matching_words_da, target, *(long *)(node->data));
+      /* Add the indexes to the search set. */
+      /* """""""""""""""""""""""""""""""""" */
+      posting_iter_init(&it, posting);
+      while (posting_iter_next(&it, &pos))
+        BIT_ON(matching_words_bits, pos);
 
-        node = node->next;
-      }
+      collect_matching_words();
     }
     else
       current = first_selectable;
@@ -13285,14 +14223,13 @@ main(int argc, char *argv[])
     }
     else
     {
-      int  found = 0;
-      long target;
+      int found = 0;
 
       /* A prefix is expected. */
       /* """"""""""""""""""""" */
       for (new_current = first_selectable; new_current < count; new_current++)
       {
-        if (strprefix(word_a[new_current].str, ptr)
+        if (strprefix(word_cold_a[new_current].str, ptr)
             && word_a[new_current].is_selectable)
         {
           if (!found)
@@ -13301,16 +14238,14 @@ main(int argc, char *argv[])
             found   = 1;
           }
 
-          /* Insert the index in the search array. */
-          /* """"""""""""""""""""""""""""""""""""" */
-          target = get_sorted_array_target_pos(matching_words_da,
-                                               BUF_LEN(matching_words_da),
-                                               new_current);
-          if (target >= 0)
-            BUF_INSERT(matching_words_da, target, new_current);
+          /* Add the index to the search set. */
+          /* """""""""""""""""""""""""""""""" */
+          BIT_ON(matching_words_bits, new_current);
         }
       }
 
+      collect_matching_words();
+
       if (!found)
         current = first_selectable;
     }
@@ -13945,8 +14880,8 @@ main(int argc, char *argv[])
           /* """"""""""""""""""""""""""""""""""""""""" */
           if (matching_nb > 0)
           {
-            int   offset = word_a[current].offset;
-            long  len_mb = word_a[current].len_mb;
+            int   offset = word_cold_a[current].offset;
+            long  len_mb = word_cold_a[current].len_mb;
             long  mb_index;
             long *work_a;
             long *work_mb_a;
@@ -13957,7 +14892,7 @@ main(int argc, char *argv[])
 
             /* Get the position of the latest selected glyph. */
             /* """""""""""""""""""""""""""""""""""""""""""""" */
-            while (!BIT_ISSET(word_a[current].bitmap, mb_index))
+            while (!BIT_ISSET(word_bitmap(current), mb_index))
               mb_index--;
 
             /* Array to contain the offset (in bytes) of the last  */
@@ -13980,22 +14915,23 @@ main(int argc, char *argv[])
 
             for (long i = 0; i < matching_nb; i++)
             {
-              int offset = word_a[matching_words_da[i]].offset;
-              len_mb     = word_a[matching_words_da[i]].len_mb;
+              int offset = word_cold_a[matching_words_da[i]].offset;
+              len_mb     = word_cold_a[matching_words_da[i]].len_mb;
 
               mb_index = len_mb - 1 + offset - daccess.flength;
 
               /* Determine the index of the first non selected glyph */
               /* after the last selected one.                        */
               /* """"""""""""""""""""""""""""""""""""""""""""""""""" */
-              while (!BIT_ISSET(word_a[matching_words_da[i]].bitmap, mb_index))
+              while (!BIT_ISSET(word_bitmap(matching_words_da[i]), mb_index))
                 mb_index--;
               mb_index++;
 
               /* ptr will point to the first non selected glyph */
               /* after the last one.                            */
               /* """""""""""""""""""""""""""""""""""""""""""""" */
-              ptr = word_a[matching_words_da[i]].str + daccess.flength + offset;
+              ptr = word_cold_a[matching_words_da[i]].str + daccess.flength
+                    + offset;
 
               for (long j = 0; j < mb_index - offset; j++)
                 ptr = utf8_next(ptr);
@@ -14005,7 +14941,7 @@ main(int argc, char *argv[])
               /* """""""""""""""""""""""""""""""""""""""""""""" */
               if (ptr != NULL)
               {
-                work_a[i]    = ptr - word_a[matching_words_da[i]].str;
+                work_a[i]    = ptr - word_cold_a[matching_words_da[i]].str;
                 work_mb_a[i] = mb_index;
               }
               else
@@ -14025,11 +14961,12 @@ main(int argc, char *argv[])
             /* """"""""""""""""""""""""""""""""" */
             if (shortest_mb_seq > 0)
             {
-              ptr = word_a[matching_words_da[ref_word]].str + work_a[ref_word];
+              ptr = word_cold_a[matching_words_da[ref_word]].str
+                    + work_a[ref_word];
 
-              while ((size_t)(ptr - word_a[matching_words_da[ref_word]].str
-                              - word_a[matching_words_da[ref_word]].offset)
-                     < word_a[matching_words_da[ref_word]].len)
+              while ((size_t)(ptr - word_cold_a[matching_words_da[ref_word]].str
+                              - word_cold_a[matching_words_da[ref_word]].offset)
+                     < word_cold_a[matching_words_da[ref_word]].len)
               {
                 char glyph[5];
                 int  l    = utf8_get_length(*(ptr));
@@ -14049,7 +14986,8 @@ main(int argc, char *argv[])
                   if (i != ref_word)
                   {
                     if (memcmp(glyph,
-                               word_a[matching_words_da[i]].str + work_a[i],
+                               word_cold_a[matching_words_da[i]].str
+                                 + work_a[i],
                                l)
                         != 0)
                     {
@@ -14094,7 +15032,7 @@ main(int argc, char *argv[])
                   /* Mark the remaining glyphs as selected. */
                   /* """""""""""""""""""""""""""""""""""""" */
                   for (long i = 0; i < matching_nb; i++)
-                    BIT_ON(word_a[matching_words_da[i]].bitmap,
+                    BIT_ON(word_cold_a[matching_words_da[i]].bitmap,
                            work_mb_a[i] - 1);
 
                   /* In fuzzy mode, each glyph in search_data.buf is */
@@ -14102,7 +15040,23 @@ main(int argc, char *argv[])
                   /* to do the same thing here.                      */
                   /* """"""""""""""""""""""""""""""""""""""""""""""" */
                   if (search_mode == FUZZY)
-                    append_tst_search_list(ptr, l);
+                  {
+                    if (fuzzy_index != NULL)
+                    {
+                      sub_tst_t *sub_tst_data = sub_tst_new();
+                      wchar_t   *w           = utf8_strtowcs(glyph);
+
+                      fuzzy_index_search(fuzzy_index,
+                                         tst_search_list->tail->data,
+                                         sub_tst_data,
+                                         w[0]);
+                      ll_append(tst_search_list, sub_tst_data);
+
+                      free(w);
+                    }
+                    else
+                      append_tst_search_list(ptr, l);
+                  }
                 }
               }
             }
@@ -14180,6 +15134,7 @@ main(int argc, char *argv[])
               search_data.only_starting = 1;
               search_data.only_ending   = 0;
               select_starting_matches(&win, &term, &search_data, &last_line);
+              clear_saved_matching_words();
             }
             else
             {
@@ -14237,6 +15192,7 @@ main(int argc, char *argv[])
                 search_data.only_starting = 0;
                 search_data.only_ending   = 1;
                 select_ending_matches(&win, &term, &search_data, &last_line);
+                clear_saved_matching_words();
               }
             }
             else
@@ -14468,6 +15424,10 @@ main(int argc, char *argv[])
           /* """"""""""""""""""""""""""""""""""""" */
           (void)tputs(TPARM1(cursor_normal), 1, outch);
 
+          /* Release at once the storage of the words. */
+          /* """"""""""""""""""""""""""""""""""""""""" */
+          arena_free(word_arena);
+
           if (buffer[0] == 3) /* ^C */
           {
             if (int_string != NULL)
@@ -14778,19 +15738,19 @@ main(int argc, char *argv[])
               /* When using -P, updates the tagging order of this word to */
               /* make sure that the output will be correctly sorted.      */
               /* """""""""""""""""""""""""""""""""""""""""""""""""""""""" */
-              if (word_a[current].tag_id == 0 && toggles.pinable)
-                word_a[current].tag_order = tag_nb++;
+              if (word_cold_a[current].tag_id == 0 && toggles.pinable)
+                word_cold_a[current].tag_order = tag_nb++;
 
               for (wi = 0; wi < count; wi++)
               {
-                if (word_a[wi].tag_id > 0 || wi == current)
+                if (word_cold_a[wi].tag_id > 0 || wi == current)
                 {
                   /* If the -p option is not used we do not take into      */
                   /* account an untagged word under the cursor if at least */
                   /* on word is tagged.                                    */
                   /* """"""""""""""""""""""""""""""""""""""""""""""""""""" */
                   if (wi == current && tagged_words > 0 && !toggles.autotag
-                      && word_a[wi].tag_id == 0)
+                      && word_cold_a[wi].tag_id == 0)
                     continue;
 
                   /* In tagged mode, do not automatically tag the word   */
@@ -14806,10 +15766,10 @@ main(int argc, char *argv[])
                   /* """"""""""""""""""""""""""""""""""""""""""""""""""""" */
                   output_node = xmalloc(sizeof(output_t));
 
-                  if (word_a[wi].orig != NULL)
-                    str = word_a[wi].orig;
+                  if (word_cold_a[wi].orig != NULL)
+                    str = word_cold_a[wi].orig;
                   else
-                    str = word_a[wi].str;
+                    str = word_cold_a[wi].str;
 
                   if (word_a[wi].is_numbered && daccess.num_sep)
                   {
@@ -14828,7 +15788,7 @@ main(int argc, char *argv[])
                   else
                     output_node->output_str = xstrdup(str + daccess.flength);
 
-                  output_node->order = word_a[wi].tag_order;
+                  output_node->order = word_cold_a[wi].tag_order;
 
                   /* Trim the spaces if -k is not given. */
                   /* """"""""""""""""""""""""""""""""""" */
@@ -14893,10 +15853,10 @@ main(int argc, char *argv[])
               /* been altered by a possible expansion.                     */
               /* Once this made, print it.                                 */
               /* """"""""""""""""""""""""""""""""""""""""""""""""""""""""" */
-              if (word_a[current].orig != NULL)
-                str = word_a[current].orig;
+              if (word_cold_a[current].orig != NULL)
+                str = word_cold_a[current].orig;
               else
-                str = word_a[current].str;
+                str = word_cold_a[current].str;
 
               if (word_a[current].is_numbered && daccess.num_sep)
               {
@@ -14973,6 +15933,10 @@ main(int argc, char *argv[])
           (void)tputs(TPARM1(carriage_return), 1, outch);
           restore_term(fileno(stdin), &old_in_attrs);
 
+          /* Release at once the storage of the words. */
+          /* """"""""""""""""""""""""""""""""""""""""" */
+          arena_free(word_arena);
+
           exit(EXIT_SUCCESS);
         }
 
@@ -15613,13 +16577,13 @@ main(int argc, char *argv[])
           /* The INS key has been pressed to tag a word if */
           /* tagging is enabled.                           */
           /* """"""""""""""""""""""""""""""""""""""""""""" */
-          if (toggles.taggable && word_a[current].tag_id == 0)
+          if (toggles.taggable && word_cold_a[current].tag_id == 0)
           {
-            word_a[current].tag_id = win.next_tag_id++;
+            word_cold_a[current].tag_id = win.next_tag_id++;
             tagged_words++;
 
             if (toggles.pinable)
-              word_a[current].tag_order = tag_nb++;
+              word_cold_a[current].tag_order = tag_nb++;
 
             nl = disp_lines(&win,
                             &toggles,
@@ -15641,14 +16605,14 @@ main(int argc, char *argv[])
           /* The DEL key has been pressed to untag a word if */
           /* tagging is enabled.                             */
           /* """"""""""""""""""""""""""""""""""""""""""""""" */
-          if (toggles.taggable && word_a[current].tag_id > 0)
+          if (toggles.taggable && word_cold_a[current].tag_id > 0)
           {
-            word_a[current].tag_id = 0;
+            word_cold_a[current].tag_id = 0;
             tagged_words--;
 
             /* We do not try to change tag_nb here to guaranty that */
             /* tag_nb will be greater than all those already stored */
-            /* in all word_a[*].tag_order.                          */
+            /* in all word_cold_a[*].tag_order.                     */
             /* '''''''''''''''''''''''''''''''''''''''''''''''''''' */
 
             nl = disp_lines(&win,
@@ -15675,18 +16639,18 @@ main(int argc, char *argv[])
           {
             if (toggles.taggable)
             {
-              if (word_a[current].tag_id > 0)
+              if (word_cold_a[current].tag_id > 0)
               {
-                word_a[current].tag_id = 0;
+                word_cold_a[current].tag_id = 0;
                 tagged_words--;
               }
               else
               {
-                word_a[current].tag_id = win.next_tag_id++;
+                word_cold_a[current].tag_id = win.next_tag_id++;
                 tagged_words++;
 
                 if (toggles.pinable)
-                  word_a[current].tag_order = tag_nb++;
+                  word_cold_a[current].tag_order = tag_nb++;
               }
 
               nl = disp_lines(&win,
@@ -15716,9 +16680,9 @@ main(int argc, char *argv[])
           {
             if (toggles.taggable)
             {
-              if (word_a[current].tag_id > 0)
+              if (word_cold_a[current].tag_id > 0)
               {
-                word_a[current].tag_id = 0;
+                word_cold_a[current].tag_id = 0;
                 tagged_words--;
 
                 nl = disp_lines(&win,
@@ -15754,8 +16718,8 @@ main(int argc, char *argv[])
 
               for (wi = 0; wi < count; wi++)
               {
-                word_a[wi].tag_id    = 0;
-                word_a[wi].tag_order = 0;
+                word_cold_a[wi].tag_id    = 0;
+                word_cold_a[wi].tag_order = 0;
               }
 
               nl = disp_lines(&win,
@@ -15847,17 +16811,17 @@ main(int argc, char *argv[])
               {
                 col++;
                 if (col == cur_col && word_a[wi].is_selectable
-                    && word_a[wi].tag_id == 0)
+                    && word_cold_a[wi].tag_id == 0)
                 {
-                  word_a[wi].tag_id = win.next_tag_id;
+                  word_cold_a[wi].tag_id = win.next_tag_id;
                   tagged_words++;
 
                   if (toggles.pinable)
                   {
                     if (marked <= current)
-                      word_a[wi].tag_order = tag_nb++;
+                      word_cold_a[wi].tag_order = tag_nb++;
                     else
-                      word_a[wi].tag_order = tag_nb--;
+                      word_cold_a[wi].tag_order = tag_nb--;
                   }
 
                   tagged = 1;
@@ -15981,17 +16945,17 @@ main(int argc, char *argv[])
               {
                 if (word_a[wi].is_selectable)
                 {
-                  if (word_a[wi].tag_id == 0)
+                  if (word_cold_a[wi].tag_id == 0)
                   {
-                    word_a[wi].tag_id = win.next_tag_id;
+                    word_cold_a[wi].tag_id = win.next_tag_id;
                     tagged_words++;
 
                     if (toggles.pinable)
                     {
                       if (marked <= current)
-                        word_a[wi].tag_order = tag_nb++;
+                        word_cold_a[wi].tag_order = tag_nb++;
                       else
-                        word_a[wi].tag_order = tag_nb--;
+                        word_cold_a[wi].tag_order = tag_nb--;
                     }
 
                     tagged = 1;
@@ -16130,13 +17094,13 @@ main(int argc, char *argv[])
                 {
                   wi = matching_words_da[i];
 
-                  if (word_a[wi].tag_id == 0)
+                  if (word_cold_a[wi].tag_id == 0)
                   {
-                    word_a[wi].tag_id = win.next_tag_id;
+                    word_cold_a[wi].tag_id = win.next_tag_id;
                     tagged_words++;
 
                     if (toggles.pinable)
-                      word_a[wi].tag_order = tag_nb++;
+                      word_cold_a[wi].tag_order = tag_nb++;
 
                     tagged = 1;
                   }
@@ -16177,17 +17141,17 @@ main(int argc, char *argv[])
                     if (!word_a[wi].is_selectable)
                       continue;
 
-                    if (word_a[wi].tag_id == 0)
+                    if (word_cold_a[wi].tag_id == 0)
                     {
-                      word_a[wi].tag_id = win.next_tag_id;
+                      word_cold_a[wi].tag_id = win.next_tag_id;
                       tagged_words++;
 
                       if (toggles.pinable)
                       {
                         if (marked <= current)
-                          word_a[wi].tag_order = tag_nb++;
+                          word_cold_a[wi].tag_order = tag_nb++;
                         else
-                          word_a[wi].tag_order = tag_nb--;
+                          word_cold_a[wi].tag_order = tag_nb--;
                       }
 
                       tagged = 1;
@@ -16289,11 +17253,11 @@ main(int argc, char *argv[])
                 if (!word_a[wi].is_selectable)
                   continue;
 
-                if (word_a[wi].tag_id > 0)
+                if (word_cold_a[wi].tag_id > 0)
                 {
-                  if (word_a[wi].tag_id == win.next_tag_id - 1)
+                  if (word_cold_a[wi].tag_id == win.next_tag_id - 1)
                   {
-                    word_a[wi].tag_id = 0;
+                    word_cold_a[wi].tag_id = 0;
                     tagged_words--;
                   }
                 }
@@ -16454,10 +17418,10 @@ main(int argc, char *argv[])
                     long n = matching_words_da[i];
 
                     word_a[n].is_matching = 0;
-
-                    clear_bitmap(&word_a[n]);
                   }
 
+                  invalidate_bitmaps();
+
                   BUF_CLEAR(matching_words_da);
 
                   *search_data.buf = '\0';
@@ -16514,7 +17478,8 @@ main(int argc, char *argv[])
 
                   search_data.err = 0;
 
-                  sub_tst_data->count = 0;
+                  sub_tst_data->count    = 0;
+                  sub_tst_data->nb_cands = 0;
                 }
               }
             }
@@ -16986,7 +17951,7 @@ main(int argc, char *argv[])
                     if ((button == 2 && state == 0)
                         && (toggles.taggable || toggles.pinable))
                     {
-                      if (word_a[current].tag_id > 0)
+                      if (word_cold_a[current].tag_id > 0)
                         goto kdel;
                       else
                         goto kins;
@@ -17114,14 +18079,21 @@ main(int argc, char *argv[])
                   long n = matching_words_da[i];
 
                   word_a[n].is_matching = 0;
-
-                  clear_bitmap(&word_a[n]);
                 }
 
-                /* matching_words_da is updated by tst_search_cb. */
-                /* """""""""""""""""""""""""""""""""""""""""""""" */
-                BUF_CLEAR(matching_words_da);
-                tst_prefix_search(tst_word, ws, tst_search_cb);
+                invalidate_bitmaps();
+
+                /* After a backspace, the previous set of matching words */
+                /* is restored if it was saved, otherwise the matching   */
+                /* words are collected by tst_search_cb.                 */
+                /* """"""""""""""""""""""""""""""""""""""""""""""""""""" */
+                if ((buffer[0] != 0x08 && buffer[0] != 0x7f)
+                    || !restore_matching_words(search_data.mb_len))
+                {
+                  save_matching_words(old_mb_len, search_data.mb_len);
+                  tst_prefix_search(tst_word, ws, tst_search_cb);
+                  collect_matching_words();
+                }
 
                 if (BUF_LEN(matching_words_da) > 0)
                 {
@@ -17166,6 +18138,8 @@ main(int argc, char *argv[])
 
                   search_data.buf[search_data.len] = '\0';
 
+                  discard_saved_matching_words(search_data.mb_len);
+
                   /* Set new first column to display. */
                   /* """""""""""""""""""""""""""""""" */
                   set_new_first_column(&win, &term);
@@ -17194,6 +18168,7 @@ main(int argc, char *argv[])
                 /* Each of these node starts a matching candidate.        */
                 /* """""""""""""""""""""""""""""""""""""""""""""""""""""" */
                 wchar_t *w = utf8_strtowcs(search_data.buf + old_len);
+                int      restored;
 
                 /* zero previous matching indicators. */
                 /* """""""""""""""""""""""""""""""""" */
@@ -17202,22 +18177,37 @@ main(int argc, char *argv[])
                   long n = matching_words_da[i];
 
                   word_a[n].is_matching = 0;
-
-                  clear_bitmap(&word_a[n]);
                 }
 
-                BUF_CLEAR(matching_words_da);
+                invalidate_bitmaps();
+
+                /* After a backspace, the previous set of matching words */
+                /* is restored if it was saved.                          */
+                /* """"""""""""""""""""""""""""""""""""""""""""""""""""" */
+                if (buffer[0] == 0x08 || buffer[0] == 0x7f)
+                {
+                  restored = restore_matching_words(search_data.mb_len);
+                  if (!restored)
+                    BUF_CLEAR(matching_words_da);
+                }
+                else
+                {
+                  restored = 0;
+                  save_matching_words(old_mb_len, search_data.mb_len);
+                }
 
                 if (buffer[0] == 0x08 || buffer[0] == 0x7f) /* Backspace */
                 {
                   node         = tst_search_list->tail;
                   sub_tst_data = (sub_tst_t *)(node->data);
 
-                  sub_tst_data->count = 0;
+                  sub_tst_data->count    = 0;
+                  sub_tst_data->nb_cands = 0;
 
                   if (tst_search_list->len > 0)
                   {
                     free(sub_tst_data->array);
+                    free(sub_tst_data->cands);
                     free(sub_tst_data);
 
                     ll_delete(tst_search_list, tst_search_list->tail);
@@ -17225,17 +18215,31 @@ main(int argc, char *argv[])
                 }
                 else
                 {
+                  /* The index of the words is built the first time a     */
+                  /* fuzzy search is done.                                */
+                  /* """""""""""""""""""""""""""""""""""""""""""""""""""" */
+                  if (!fuzzy_index_built)
+                  {
+                    fuzzy_index       = fuzzy_index_new(tst_word);
+                    fuzzy_index_built = 1;
+                  }
+
                   if (search_data.mb_len == 1)
                   {
+                    node         = tst_search_list->tail;
+                    sub_tst_data = (sub_tst_t *)(node->data);
+
                     /* Search all the sub-tst trees having the first      */
                     /* searched character as children and store them in   */
                     /* the sub tst array attached to the searched symbol. */
+                    /* With the index, only keep the words containing it. */
                     /* """""""""""""""""""""""""""""""""""""""""""""""""" */
-                    tst_fuzzy_traverse(tst_word, NULL, 0, w[0]);
+                    if (fuzzy_index != NULL)
+                      fuzzy_index_search(fuzzy_index, NULL, sub_tst_data, w[0]);
+                    else
+                      tst_fuzzy_traverse(tst_word, NULL, w[0]);
 
-                    node         = tst_search_list->tail;
-                    sub_tst_data = (sub_tst_t *)(node->data);
-                    if (sub_tst_data->count == 0)
+                    if (sub_tst_data->count == 0 && sub_tst_data->nb_cands == 0)
                     {
                       my_beep(&toggles);
 
@@ -17268,16 +18272,25 @@ main(int argc, char *argv[])
                       node         = tst_search_list->tail->prev;
                       sub_tst_data = (sub_tst_t *)(node->data);
 
+                      /* The index only has to check the candidates of  */
+                      /* the previous level.                            */
+                      /* """""""""""""""""""""""""""""""""""""""""""""" */
                       rc = 0;
-                      for (index = 0; index < sub_tst_data->count; index++)
-                        rc += tst_fuzzy_traverse(sub_tst_data->array[index],
-                                                 NULL,
-                                                 1,
-                                                 w[0]);
+                      if (fuzzy_index != NULL)
+                        rc = fuzzy_index_search(fuzzy_index,
+                                                sub_tst_data,
+                                                tst_fuzzy_level_data,
+                                                w[0]);
+                      else
+                        for (index = 0; index < sub_tst_data->count; index++)
+                          rc += tst_fuzzy_traverse(sub_tst_data->array[index],
+                                                   NULL,
+                                                   w[0]);
 
                       if (rc == 0)
                       {
                         free(tst_fuzzy_level_data->array);
+                        free(tst_fuzzy_level_data->cands);
                         free(tst_fuzzy_level_data);
 
                         ll_delete(tst_search_list, tst_search_list->tail);
@@ -17292,10 +18305,19 @@ main(int argc, char *argv[])
                         search_data.mb_len = old_mb_len;
 
                         search_data.buf[search_data.len] = '\0';
+
+                        /* The matching words are still those of the */
+                        /* previous level.                           */
+                        /* """"""""""""""""""""""""""""""""""""""""" */
+                        restored = restore_matching_words(old_mb_len);
                       }
                     }
                     else
+                    {
                       my_beep(&toggles);
+
+                      restored = restore_matching_words(old_mb_len);
+                    }
                   }
                 }
                 free(w);
@@ -17303,13 +18325,21 @@ main(int argc, char *argv[])
                 /* Process this level to mark the word found as a matching */
                 /* word if any.                                            */
                 /* """"""""""""""""""""""""""""""""""""""""""""""""""""""" */
-                node         = tst_search_list->tail;
-                sub_tst_data = (sub_tst_t *)(node->data);
+                if (!restored)
+                {
+                  node         = tst_search_list->tail;
+                  sub_tst_data = (sub_tst_t *)(node->data);
 
-                for (index = 0; index < sub_tst_data->count; index++)
-                  tst_traverse(sub_tst_data->array[index],
-                               set_matching_flag,
-                               0);
+                  for (index = 0; index < sub_tst_data->count; index++)
+                    tst_traverse(sub_tst_data->array[index], set_matching_flag);
+
+                  if (fuzzy_index != NULL)
+                    fuzzy_index_traverse(fuzzy_index,
+                                         sub_tst_data,
+                                         set_matching_flag);
+
+                  collect_matching_words();
+                }
 
                 /* Update the bitmap and re-display the window. */
                 /* """""""""""""""""""""""""""""""""""""""""""" */
@@ -17330,7 +18360,12 @@ main(int argc, char *argv[])
                     /* """""""""""""""""""""""""""""""""""""""" */
                     update_bitmaps(search_mode, &search_data, NO_AFFINITY);
 
-                  current = matching_words_da[0];
+                  /* Put the cursor on the best scored match. */
+                  /* """""""""""""""""""""""""""""""""""""""" */
+                  if (BUF_LEN(ranked_words_da) > 0)
+                    current = ranked_words_da[0].index;
+                  else
+                    current = matching_words_da[0];
 
                   if (current < win.start || current > win.end)
                     last_line = build_metadata(&term, count, &win);
@@ -17364,42 +18399,65 @@ main(int argc, char *argv[])
                   long n = matching_words_da[i];
 
                   word_a[n].is_matching = 0;
-
-                  clear_bitmap(&word_a[n]);
                 }
 
-                BUF_CLEAR(matching_words_da);
+                invalidate_bitmaps();
 
-                if (search_data.mb_len == 1)
+                /* After a backspace, the previous set of matching words */
+                /* is restored if it was saved.                          */
+                /* """"""""""""""""""""""""""""""""""""""""""""""""""""" */
+                if ((buffer[0] != 0x08 && buffer[0] != 0x7f)
+                    || !restore_matching_words(search_data.mb_len))
                 {
-                  /* Search all the sub-tst trees having the first      */
-                  /* searched character as children and store them in   */
-                  /* the sub tst array attached to the searched symbol. */
-                  /* """""""""""""""""""""""""""""""""""""""""""""""""" */
-                  tst_substring_traverse(tst_word, NULL, 0, w[0]);
+                  save_matching_words(old_mb_len, search_data.mb_len);
 
-                  node         = tst_search_list->tail;
-                  sub_tst_data = (sub_tst_t *)(node->data);
+                  /* The suffix array of the words is built the first time   */
+                  /* a substring search is done.                             */
+                  /* """"""""""""""""""""""""""""""""""""""""""""""""""""""" */
+                  if (!substring_sa_built)
+                  {
+                    substring_sa       = sa_new(tst_word);
+                    substring_sa_built = 1;
+                  }
 
-                  for (index = 0; index < sub_tst_data->count; index++)
-                    tst_traverse(sub_tst_data->array[index],
-                                 set_matching_flag,
-                                 0);
-                }
-                else
-                {
-                  /* Search for the rest of the word in all the sub-tst */
-                  /* trees previously found.                            */
-                  /* """""""""""""""""""""""""""""""""""""""""""""""""" */
-                  node         = tst_search_list->tail;
-                  sub_tst_data = (sub_tst_t *)(node->data);
+                  /* Each key stroke only needs two binary searches in the   */
+                  /* suffix array, the TST based search is only used if      */
+                  /* the words were too large to be indexed.                 */
+                  /* """"""""""""""""""""""""""""""""""""""""""""""""""""""" */
+                  if (substring_sa != NULL)
+                    sa_search(substring_sa, w, tst_search_cb);
+                  else if (search_data.mb_len == 1)
+                  {
+                    /* Search all the sub-tst trees having the first      */
+                    /* searched character as children and store them in   */
+                    /* the sub tst array attached to the searched symbol. */
+                    /* """""""""""""""""""""""""""""""""""""""""""""""""" */
+                    tst_substring_traverse(tst_word, NULL, w[0]);
 
-                  BUF_CLEAR(matching_words_da);
+                    node         = tst_search_list->tail;
+                    sub_tst_data = (sub_tst_t *)(node->data);
 
-                  for (index = 0; index < sub_tst_data->count; index++)
-                    tst_prefix_search(sub_tst_data->array[index],
-                                      w + 1,
-                                      tst_search_cb);
+                    for (index = 0; index < sub_tst_data->count; index++)
+                      tst_traverse(sub_tst_data->array[index],
+                                   set_matching_flag);
+                  }
+                  else
+                  {
+                    /* Search for the rest of the word in all the sub-tst */
+                    /* trees previously found.                            */
+                    /* """""""""""""""""""""""""""""""""""""""""""""""""" */
+                    node         = tst_search_list->tail;
+                    sub_tst_data = (sub_tst_t *)(node->data);
+
+                    BUF_CLEAR(matching_words_da);
+
+                    for (index = 0; index < sub_tst_data->count; index++)
+                      tst_prefix_search(sub_tst_data->array[index],
+                                        w + 1,
+                                        tst_search_cb);
+                  }
+
+                  collect_matching_words();
                 }
 
                 if (BUF_LEN(matching_words_da) > 0)
@@ -17453,6 +18511,8 @@ main(int argc, char *argv[])
                   search_data.mb_len--;
                   search_data.buf[search_data.len] = '\0';
 
+                  discard_saved_matching_words(search_data.mb_len);
+
                   /* Set new first column to display. */
                   /* """""""""""""""""""""""""""""""" */
                   set_new_first_column(&win, &term);
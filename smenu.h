@@ -9,16 +9,19 @@
 #ifndef SMENU_H
 #define SMENU_H
 
-#include <limits.h> /* for CHAR_BIT     */
-#include <regex.h>  /* for regex_t      */
-#include <stdio.h>  /* for size_t, FILE */
-#include <term.h>   /* for tparm        */
-#include "list.h"   /* for ll_t         */
-#include "utf8.h"   /* for langinfo_t   */
+#include <limits.h> /* for CHAR_BIT      */
+#include <regex.h>  /* for regex_t       */
+#include <stdio.h>  /* for size_t, FILE  */
+#include <term.h>   /* for tparm         */
+#include "list.h"   /* for ll_t          */
+#include "utf8.h"   /* for langinfo_t    */
+#include "fgetc.h"  /* for in_buf_t      */
+#include "utils.h"  /* for glyph_class_t */
 
 #define CHARSCHUNK 8
 #define WORDSCHUNK 8
 #define COLSCHUNK 16
+#define ARENACHUNK 65536
 
 #define TPARM1(p) tparm(p, 0, 0, 0, 0, 0, 0, 0, 0, 0)
 #define TPARM2(p, q) tparm(p, q, 0, 0, 0, 0, 0, 0, 0, 0)
@@ -30,6 +33,22 @@
 #define FREQ 10
 #define TCK (SECOND / FREQ)
 
+/* Number of words read between two looks at the clock, */
+/* see disp_reading_progress.                           */
+/* """""""""""""""""""""""""""""""""""""""""""""""""""" */
+#define PROGRESS_WORDS 256
+
+/* Used to rank the fuzzy matches, see fuzzy_score. */
+/* """""""""""""""""""""""""""""""""""""""""""""""" */
+#define SCORE_MATCH 16
+#define SCORE_CONSECUTIVE 8
+#define SCORE_BOUNDARY 8
+#define SCORE_GAP_START 3
+#define SCORE_GAP 1
+#define SCORE_NONE (LONG_MIN / 2)
+#define SCORE_MAX_CELLS 4096 /* max DP cells before greedy scoring.        */
+#define RANKED_WORDS_NB 16   /* number of best scored fuzzy matches kept.  */
+
 /* Large bit array management written by           */
 /* Scott Dudley, Auke Reitsma and Bob Stout.       */
 /* Assumes CHAR_BIT is one of either 8, 16, or 32. */
@@ -52,6 +71,7 @@ typedef struct term_s            term_t;
 typedef struct toggle_s          toggle_t;
 typedef struct win_s             win_t;
 typedef struct word_s            word_t;
+typedef struct word_cold_s       word_cold_t;
 typedef struct attrib_s          attrib_t;
 typedef struct attrib_ex_s       attrib_ex_t;
 typedef struct limit_s           limit_t;
@@ -66,6 +86,7 @@ typedef struct search_data_s     search_data_t;
 typedef struct attr_elem_s       attr_elem_t;
 typedef struct help_entry_s      help_entry_t;
 typedef struct help_attr_entry_s help_attr_entry_t;
+typedef struct ranked_word_s     ranked_word_t;
 
 /* ****** */
 /* Enums. */
@@ -168,6 +189,17 @@ enum
                           | but can be excluded later.                   */
 };
 
+/* Classes of the glyphs read from the input. */
+/* """""""""""""""""""""""""""""""""""""""""" */
+enum
+{
+  WORD_DELIM_GLYPH = 1, /* word delimiter (-W).                        */
+  LINE_DELIM_GLYPH = 2, /* line delimiter (-L).                        */
+  ZAPPED_GLYPH     = 4, /* glyph to be ignored (-z).                   */
+  SPECIAL_GLYPH    = 8  /* byte to be examined individually by         *
+                         | read_word (quotes, \, ESC, non ASCII, NUL). */
+};
+
 /* Mouse protocols. */
 /* """""""""""""""" */
 enum
@@ -335,35 +367,51 @@ struct term_s
   char has_rep;               /* has repeat char.                        */
 };
 
-/* Structure describing a word. */
-/* """""""""""""""""""""""""""" */
+/* Structure describing a word. Only the fields read while moving */
+/* the cursor and building the lines are kept here to make the    */
+/* scans over word_a cheap, the others are in word_cold_s.        */
+/* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
 struct word_s
 {
-  long          start, end;    /* start/end absolute horiz. word positions *
-                                | on the screen.                           */
-  size_t        mb;            /* number of UTF-8 glyphs to display.       */
-  size_t        len_mb;        /* number of UTF-8 glyphs before filling    *
-                                * the column.                              */
-  size_t        len;           /* number of bytes in str (for trimming).   */
-  char         *str;           /* display string associated with this word */
-  char         *orig;          /* NULL or original string if is had been.  *
-                                | shortened for being displayed or altered *
-                                | by is expansion.                         */
-  char         *bitmap;        /* used to store the position of the.       *
-                                | currently searched chars in a word. The  *
-                                | objective is to speed their display.     */
-  attrib_t     *iattr;         /* Specific attribute set with the -Ra/-Ca  *
-                                | options.                                 */
-  long          tag_order;     /* each time a word is tagged, this value.  *
-                                | is increased.                            */
-  int           offset;        /* may be > 0 in case of center or right    *
-                                * alignment (# of spaces added).           */
-  unsigned      tag_id;        /* tag id. 0 means no tag.                  */
-  unsigned char is_matching;   /* word is matching a search ERE.           */
-  unsigned char is_last;       /* 1 if the word is the last of a line.     */
-  unsigned char is_selectable; /* word is selectable.                      */
-  unsigned char is_numbered;   /* word has a direct access index.          */
-  unsigned char special_level; /* can vary from 0 to 9; 0 meaning normal.  */
+  int      start, end;        /* start/end absolute horiz. word positions *
+                               | on the screen.                           */
+  int      mb;                /* number of UTF-8 glyphs to display.       */
+  int      nb_glyphs;         /* number of glyphs in the whole word and   */
+  int      width;             /* its width, both set once at load time.   */
+  unsigned is_matching   : 1; /* word is matching a search ERE.           */
+  unsigned is_last       : 1; /* 1 if the word is the last of a line.     */
+  unsigned is_selectable : 2; /* word is selectable.                      */
+  unsigned is_numbered   : 1; /* word has a direct access index.          */
+  unsigned special_level : 4; /* can vary from 0 to 9; 0 meaning normal.  */
+};
+
+/* Less frequently used fields of a word, word_cold_a[i] completes */
+/* word_a[i].                                                      */
+/* """"""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+struct word_cold_s
+{
+  char     *str;        /* display string associated with this word */
+  char     *orig;       /* NULL or original string if is had been.  *
+                         | shortened for being displayed or altered *
+                         | by is expansion.                         */
+  char     *bitmap;     /* used to store the position of the.       *
+                         | currently searched chars in a word. The  *
+                         | objective is to speed their display.     */
+  char     *fold;       /* case folded version of the word without  *
+                         | its prefix and trailing blanks, used by  *
+                         | the fuzzy search.                        */
+  attrib_t *iattr;      /* Specific attribute set with the -Ra/-Ca  *
+                         | options.                                 */
+  long      tag_order;  /* each time a word is tagged, this value.  *
+                         | is increased.                            */
+  size_t    len_mb;     /* number of UTF-8 glyphs before filling    *
+                         * the column.                              */
+  size_t    len;        /* number of bytes in str (for trimming).   */
+  int       offset;     /* may be > 0 in case of center or right    *
+                         * alignment (# of spaces added).           */
+  unsigned  tag_id;     /* tag id. 0 means no tag.                  */
+  unsigned  bitmap_gen; /* value of bitmaps_gen when bitmap was     *
+                         | computed.                                */
 };
 
 /* Structure describing the window in which the user  */
@@ -389,6 +437,8 @@ struct win_s
   int      max_width;       /* max usable line width or the terminal.   */
   int      offset;          /* Left margin, used in centered mode.      */
   int      sb_column;       /* scroll bar column (-1) if no scroll bar. */
+  int      layout_width;    /* terminal width for which the lines have  *
+                             | been built, 0 if they are not built yet. */
   char    *sel_sep;         /* output separator when tags are enabled.  */
   char   **gutter_a;        /* array of UTF-8 gutter glyphs.            */
   int      gutter_nb;       /* number of UTF-8 gutter glyphs.           */
@@ -513,6 +563,14 @@ struct search_data_s
   int only_starting; /* same with the pattern at the beginning.  */
 };
 
+/* Fuzzy match kept in the heap of the best scored ones. */
+/* """"""""""""""""""""""""""""""""""""""""""""""""""""" */
+struct ranked_word_s
+{
+  long index; /* index of the word in word_a. */
+  long score; /* see fuzzy_score.             */
+};
+
 /* Structure used to store an attribute and the list of elements      */
 /* (columns, rows or RE) for which this attribute must be the default */
 /* one.                                                               */
@@ -580,13 +638,19 @@ int
 isempty(const char *s);
 
 void
-clear_bitmap(word_t *word);
+clear_bitmap(long n);
+
+char *
+fold_word(char *str);
+
+long
+get_str_width(char *str, long *nb_glyphs);
 
 void
 my_beep(toggle_t *toggles);
 
 void
-align_word(word_t *word, alignment_t alignment, size_t prerfix, char sp);
+align_word(word_cold_t *word, alignment_t alignment, size_t prerfix, char sp);
 
 int
 get_cursor_position(int * const r, int * const c);
@@ -601,6 +665,13 @@ outch(char c);
 outch(int c);
 #endif
 
+int
+#ifdef __sun
+outch_progress(char c);
+#else
+outch_progress(int c);
+#endif
+
 void
 restore_term(int const fd, struct termios *old);
 
@@ -680,23 +751,71 @@ disp_message(ll_t       *message_lines_list,
              win_t      *win,
              langinfo_t *langinfo);
 
+void
+disp_reading_progress(long count);
+
 int
 check_integer_constraint(int nb_args, char **args, char *value, char *par);
 
+void
+build_bitmap(long n, char *bm);
+
+int
+is_contiguous_match(long n);
+
 void
 update_bitmaps(search_mode_t     search_mode,
                search_data_t    *search_data,
                bitmap_affinity_t affinity);
 
+void
+invalidate_bitmaps(void);
+
+char *
+word_bitmap(long n);
+
+long
+fuzzy_score(long n);
+
+void
+set_score_bounds(void);
+
+int
+ranked_word_worse(ranked_word_t *a, ranked_word_t *b);
+
+void
+ranked_words_sift_down(long i, long nb);
+
+void
+rank_word(long n, long score);
+
+void
+sort_ranked_words(void);
+
 long
 find_next_matching_word(long *array, long nb, long value, long *index);
 
 long
 find_prev_matching_word(long *array, long nb, long value, long *index);
 
+void
+collect_matching_words(void);
+
 void
 clean_matches(search_data_t *search_data, long size);
 
+void
+save_matching_words(long old_mb_len, long mb_len);
+
+int
+restore_matching_words(long mb_len);
+
+void
+discard_saved_matching_words(long mb_len);
+
+void
+clear_saved_matching_words(void);
+
 void
 disp_cursor_word(long pos, win_t *win, term_t *term, int err);
 
@@ -720,20 +839,18 @@ expand(char       *src,
        misc_t     *misc);
 
 int
-read_bytes(FILE       *input,
-           char       *utf8_buffer,
-           ll_t       *ignored_glyphs_list,
-           langinfo_t *langinfo,
-           misc_t     *misc);
+read_bytes(in_buf_t      *input,
+           char          *utf8_buffer,
+           glyph_class_t *glyph_classes,
+           langinfo_t    *langinfo,
+           misc_t        *misc);
 
 int
 get_scancode(unsigned char *s, size_t max);
 
 char *
-read_word(FILE          *input,
-          ll_t          *word_delims_list,
-          ll_t          *line_delims_list,
-          ll_t          *ignored_glyphs_list,
+read_word(in_buf_t      *input,
+          glyph_class_t *glyph_classes,
           char          *utf8_buffer,
           unsigned char *is_last,
           toggle_t      *toggles,
@@ -15,6 +15,7 @@
 #include <stdio.h>   /* for sscanf                  */
 #include <stdlib.h>  /* for mbtowc                  */
 #include <string.h>  /* for memmove, strlen, strstr */
+#include <wctype.h>  /* for towlower, towupper      */
 #include "xmalloc.h" /* for xmalloc                 */
 #include "utf8.h"
 
@@ -530,7 +531,14 @@ utf8_strtowcs(char *s)
   wptr = w;
   for (ch = (unsigned char *)s; *ch; ch += converted)
   {
-    if ((converted = mbtowc(wptr, (char *)ch, 4)) > 0)
+    /* ASCII characters have the same value in all the locales. */
+    /* """""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+    if (*ch < 0x80)
+    {
+      *wptr++   = (wchar_t)*ch;
+      converted = 1;
+    }
+    else if ((converted = mbtowc(wptr, (char *)ch, 4)) > 0)
       wptr++;
     else
     {
@@ -544,26 +552,56 @@ utf8_strtowcs(char *s)
   return w;
 }
 
-/* ============================================================== */
-/* Poor man UTF-8 aware strtolower version.                       */
-/* Replaces all ASCII characters in src by its lowercase version. */
-/* dst must be preallocated before the call.                      */
-/* ============================================================== */
-void
-utf8_strtolower(char *dst, char *src)
+/* ================================================================== */
+/* Returns the simple case folding of the wide character c.           */
+/* towlower alone is not enough for the characters having several     */
+/* lowercase forms like the Greek final sigma, going through towupper */
+/* first gives them the same folded form.                             */
+/* ================================================================== */
+wchar_t
+wc_fold(wchar_t c)
 {
-  unsigned char c;
+  if (c < 0x80)
+    return tolower(c);
+
+  return towlower(towupper(c));
+}
 
-  while ((c = *src))
+/* ================================================================= */
+/* UTF-8 aware case folding of src, see wc_fold.                     */
+/* Each glyph is replaced by its folded version whose length in      */
+/* bytes may differ, the invalid UTF-8 bytes are copied unchanged.   */
+/* dst must be preallocated with a size of at least 2*strlen(src)+1  */
+/* bytes before the call.                                            */
+/* Returns the length in bytes of dst.                               */
+/* ================================================================= */
+size_t
+utf8_strfold(char *dst, char *src)
+{
+  unsigned char *s = (unsigned char *)src;
+  size_t         n = 0;
+  int            converted;
+  wchar_t        w;
+
+  while (*s)
   {
-    if (c >= 0x80)
-      *dst = c;
+    /* ASCII characters have the same value in all the locales. */
+    /* """""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+    if (*s < 0x80)
+    {
+      dst[n++] = tolower(*s);
+      s++;
+    }
+    else if ((converted = mbtowc(&w, (char *)s, 4)) > 0)
+    {
+      n += cptoutf8(dst + n, wc_fold(w));
+      s += converted;
+    }
     else
-      *dst = tolower(c);
-
-    src++;
-    dst++;
+      dst[n++] = *s++;
   }
 
-  *dst = '\0';
+  dst[n] = '\0';
+
+  return n;
 }
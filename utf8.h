@@ -55,7 +55,10 @@ utf8_prev(const char *str, const char *p);
 char *
 utf8_next(char *p);
 
-void
-utf8_strtolower(char *dst, char *src);
+wchar_t
+wc_fold(wchar_t c);
+
+size_t
+utf8_strfold(char *dst, char *src);
 
 #endif
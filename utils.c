@@ -16,7 +16,6 @@
 #include <stdlib.h> /* for free, strtol                     */
 #include <stddef.h> /* for size_t, NULL, ptrdiff_t, wchar_t */
 #include <limits.h> /* for INT_MAX, INT_MIN                 */
-#include <wchar.h>  /* for wcwidth                          */
 
 #ifdef HAVE_STRCASECMP
 #include <strings.h> /* for strcasecmp */
@@ -27,8 +26,13 @@
 #include <ctype.h>   /* for isprint                                         */
 #include <fcntl.h>   /* for open, O_RDONLY                                  */
 #include <errno.h>   /* for ERANGE, errno                                   */
+#ifdef __SSE2__
+#include <emmintrin.h> /* for _mm_loadu_si128, _mm_cmpeq_epi8... */
+#endif
+
 #include "xmalloc.h" /* for xmalloc, xcalloc, xrealloc                      */
 #include "list.h"    /* for ll_node_s, ll_delete, ll_node_t, ll_s, ll_sort  */
+#include "width.h"   /* for my_wcwidth                                      */
 #include "utils.h"
 
 /* ******************* */
@@ -291,6 +295,44 @@ isprint7(int i)
   return i >= 0x20 && i <= 0x7e;
 }
 
+/* ===================================================================== */
+/* Returns 1 if the n first bytes of s are all printable 7 bits ASCII    */
+/* characters else 0. Such a string has as many glyphs as bytes, each    */
+/* of them taking exactly one screen position.                           */
+/* The bytes are tested 8 at a time: for each one, the most significant  */
+/* bit of the byte itself, of the byte minus 0x20 and of the byte xor    */
+/* 0x7f minus 1 are all 0 only if it belongs to [0x20,0x7e].             */
+/* ===================================================================== */
+int
+isprint7_str(const char *s, size_t n)
+{
+  const uint64_t ones  = UINT64_C(0x0101010101010101);
+  const uint64_t highs = UINT64_C(0x8080808080808080);
+
+  while (n >= 8)
+  {
+    uint64_t x;
+
+    memcpy(&x, s, 8);
+    if ((x | (x - 0x20 * ones) | ((x ^ 0x7f * ones) - ones)) & highs)
+      return 0;
+
+    s += 8;
+    n -= 8;
+  }
+
+  while (n > 0)
+  {
+    if (!isprint7((unsigned char)*s))
+      return 0;
+
+    s++;
+    n--;
+  }
+
+  return 1;
+}
+
 /* ================================ */
 /* 8 bits aware version of isprint. */
 /* ================================ */
@@ -473,7 +515,7 @@ my_wcswidth(const wchar_t *s, size_t n)
   {
     int l;
 
-    if ((l = wcwidth(*s)) >= 0)
+    if ((l = my_wcwidth(*s)) >= 0)
     {
       /* Do not count zero-width-length glyphs. */
       /* """""""""""""""""""""""""""""""""""""" */
@@ -482,7 +524,7 @@ my_wcswidth(const wchar_t *s, size_t n)
         len += l;
     }
     else
-      return -1; /* wcwidth returned -1. */
+      return -1; /* my_wcwidth returned -1. */
 
     s++;
     m++;
@@ -491,40 +533,40 @@ my_wcswidth(const wchar_t *s, size_t n)
   return len;
 }
 
-/* ==================================================================== */
-/* Get the target index of the number to be inserted in a sorted array. */
-/*                                                                      */
-/* IN array : an already empty or sorted array.                         */
-/* IN value : the value to be inserted in the array.                    */
-/* IN nb    : the number of existing elements in the array.             */
-/*                                                                      */
-/* RETURN   : -1 if the value is already in the array of the future     */
-/*            index of value in the array.                              */
-/* ==================================================================== */
-long
-get_sorted_array_target_pos(long *array, long nb, long value)
+/* ===================================================================== */
+/* Returns the largest number of leading glyphs of s (at most n and at   */
+/* least 1) whose width, as computed by my_wcswidth, stays below max.    */
+/* This width is stored in *width.                                       */
+/* ===================================================================== */
+size_t
+my_wcswidth_fit(const wchar_t *s, size_t n, int max, int *width)
 {
-  long pos  = nb;
-  long left = 0, right = nb, middle;
+  int    len = 0;
+  size_t m   = 0;
 
-  if (nb > 0)
+  while (s[m] && m < n)
   {
-    /* Bisection search. */
-    /* """"""""""""""""" */
-    while (left < right)
-    {
-      middle = (left + right) / 2;
-      if (array[middle] == value)
-        return -1; /* Value already in array. */
-
-      if (value < array[middle])
-        right = middle;
-      else
-        left = middle + 1;
-    }
-    pos = left;
+    int l;
+
+    if ((l = my_wcwidth(s[m])) < 0)
+      break;
+
+    /* Do not count zero-width-length glyphs. */
+    /* """""""""""""""""""""""""""""""""""""" */
+    if (s[m] == L'\x200d' || s[m + 1] == L'\x200d' || s[m + 1] == L'\xfe0f'
+        || s[m + 1] == L'\x20e3')
+      l = 0;
+
+    if (m > 0 && len + l >= max)
+      break;
+
+    len += l;
+    m++;
   }
-  return pos;
+
+  *width = len;
+
+  return m;
 }
 
 /* =============================================================== */
@@ -706,3 +748,254 @@ isempty_utf8(const unsigned char *s)
   }
   return 1;
 }
+
+/* ******************************* */
+/* Glyph classification functions. */
+/* ******************************* */
+
+/* ==================================================================== */
+/* Packs a glyph of at most 4 bytes in an integer usable as a hash key. */
+/* Returns 0 if the glyph is too long to be packed.                     */
+/* ==================================================================== */
+static uint32_t
+glyph_key(const char *glyph)
+{
+  uint32_t key = 0;
+  int      i;
+
+  for (i = 0; glyph[i] != '\0'; i++)
+  {
+    if (i == 4)
+      return 0;
+
+    key = (key << 8) | (unsigned char)glyph[i];
+  }
+
+  return key;
+}
+
+/* ========================================================== */
+/* Hashes a packed glyph, the result is masked by the caller. */
+/* ========================================================== */
+static size_t
+glyph_hash(uint32_t key)
+{
+  key ^= key >> 16;
+  key *= 0x7feb352dU;
+  key ^= key >> 15;
+
+  return key;
+}
+
+/* ======================================================= */
+/* Creates a new and empty glyph classification structure. */
+/* ======================================================= */
+glyph_class_t *
+glyph_class_new(void)
+{
+  glyph_class_t *gc = xcalloc(1, sizeof(glyph_class_t));
+
+  gc->mb_size  = 16;
+  gc->mb_keys  = xcalloc(gc->mb_size, sizeof(uint32_t));
+  gc->mb_class = xcalloc(gc->mb_size, 1);
+
+  return gc;
+}
+
+/* ========================================================== */
+/* Frees the memory used by a glyph classification structure. */
+/* ========================================================== */
+void
+glyph_class_free(glyph_class_t *gc)
+{
+  free(gc->mb_keys);
+  free(gc->mb_class);
+  free(gc);
+}
+
+/* ==================================================================== */
+/* Adds the class bits flags to the glyph. Single-byte glyphs go in the */
+/* direct table, multi-byte ones in an open addressing hash set which   */
+/* is kept at most half full.                                           */
+/* Glyphs longer than 4 bytes cannot be produced by the input reader    */
+/* and are ignored.                                                     */
+/* ==================================================================== */
+void
+glyph_class_add(glyph_class_t *gc, const char *glyph, unsigned char flags)
+{
+  uint32_t key;
+  size_t   mask, i;
+
+  if (glyph[0] == '\0')
+    return;
+
+  if (glyph[1] == '\0')
+  {
+    gc->byte_class[(unsigned char)glyph[0]] |= flags;
+    return;
+  }
+
+  if ((key = glyph_key(glyph)) == 0)
+    return;
+
+  /* Grow and rehash the set if needed. */
+  /* """""""""""""""""""""""""""""""""" */
+  if (2 * (gc->mb_count + 1) > gc->mb_size)
+  {
+    uint32_t      *old_keys  = gc->mb_keys;
+    unsigned char *old_class = gc->mb_class;
+    size_t         old_size  = gc->mb_size;
+
+    gc->mb_size *= 2;
+    gc->mb_keys  = xcalloc(gc->mb_size, sizeof(uint32_t));
+    gc->mb_class = xcalloc(gc->mb_size, 1);
+    mask         = gc->mb_size - 1;
+
+    for (i = 0; i < old_size; i++)
+      if (old_keys[i] != 0)
+      {
+        size_t j = glyph_hash(old_keys[i]) & mask;
+
+        while (gc->mb_keys[j] != 0)
+          j = (j + 1) & mask;
+
+        gc->mb_keys[j]  = old_keys[i];
+        gc->mb_class[j] = old_class[i];
+      }
+
+    free(old_keys);
+    free(old_class);
+  }
+
+  mask = gc->mb_size - 1;
+  i    = glyph_hash(key) & mask;
+
+  while (gc->mb_keys[i] != 0 && gc->mb_keys[i] != key)
+    i = (i + 1) & mask;
+
+  if (gc->mb_keys[i] == 0)
+  {
+    gc->mb_keys[i] = key;
+    gc->mb_count++;
+  }
+
+  gc->mb_class[i] |= flags;
+}
+
+/* ================================================================ */
+/* Adds the class bits flags to each glyph stored in a linked list. */
+/* ================================================================ */
+void
+glyph_class_add_list(glyph_class_t *gc, ll_t *list, unsigned char flags)
+{
+  ll_node_t *node = list->head;
+
+  while (node != NULL)
+  {
+    glyph_class_add(gc, (char *)node->data, flags);
+    node = node->next;
+  }
+}
+
+/* =================================================================== */
+/* Returns the class bits of a multi-byte glyph or 0 if it has none.   */
+/* Single-byte glyphs are looked up directly by the GLYPH_CLASS macro. */
+/* =================================================================== */
+unsigned char
+glyph_class_get_mb(glyph_class_t *gc, const char *glyph)
+{
+  uint32_t key;
+  size_t   mask, i;
+
+  if (gc->mb_count == 0 || (key = glyph_key(glyph)) == 0)
+    return 0;
+
+  mask = gc->mb_size - 1;
+  i    = glyph_hash(key) & mask;
+
+  while (gc->mb_keys[i] != 0)
+  {
+    if (gc->mb_keys[i] == key)
+      return gc->mb_class[i];
+
+    i = (i + 1) & mask;
+  }
+
+  return 0;
+}
+
+/* ===================================================================== */
+/* Sets the class bits which will stop the spans computed by             */
+/* glyph_class_span. When the stopping bytes are all the bytes >= 0x80   */
+/* plus a few ASCII ones, they are recorded to allow a vectorized scan.  */
+/* Must be called again if the classes are modified.                     */
+/* ===================================================================== */
+void
+glyph_class_prepare_span(glyph_class_t *gc, unsigned char mask)
+{
+  int c;
+
+  gc->span_mask = mask;
+  gc->span_nb   = 0;
+
+  for (c = 0x80; c < 256; c++)
+    if (!(gc->byte_class[c] & mask))
+    {
+      gc->span_nb = -1;
+      return;
+    }
+
+  for (c = 0; c < 0x80; c++)
+    if (gc->byte_class[c] & mask)
+    {
+      if (gc->span_nb == (int)sizeof(gc->span_bytes))
+      {
+        gc->span_nb = -1;
+        return;
+      }
+
+      gc->span_bytes[gc->span_nb++] = (unsigned char)c;
+    }
+}
+
+/* ===================================================================== */
+/* Returns the number of leading bytes of s (of length n) which are not  */
+/* classified with one of the bits set by glyph_class_prepare_span.      */
+/* When SSE2 is available and the stopping bytes allow it, 16 bytes are  */
+/* examined at once, the remaining ones are checked using the table.     */
+/* ===================================================================== */
+size_t
+glyph_class_span(glyph_class_t *gc, const unsigned char *s, size_t n)
+{
+  size_t i = 0;
+
+#ifdef __SSE2__
+  if (gc->span_nb >= 0)
+  {
+    __m128i stops[8];
+    int     k;
+
+    for (k = 0; k < gc->span_nb; k++)
+      stops[k] = _mm_set1_epi8((char)gc->span_bytes[k]);
+
+    while (i + 16 <= n)
+    {
+      __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+      int     m = _mm_movemask_epi8(v); /* bytes >= 0x80. */
+
+      for (k = 0; k < gc->span_nb; k++)
+        m |= _mm_movemask_epi8(_mm_cmpeq_epi8(v, stops[k]));
+
+      if (m != 0)
+        break; /* the table lookup below will find the exact position. */
+
+      i += 16;
+    }
+  }
+#endif
+
+  while (i < n && !(gc->byte_class[s[i]] & gc->span_mask))
+    i++;
+
+  return i;
+}
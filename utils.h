@@ -10,11 +10,13 @@
 #define UTILS_H
 
 #include <stddef.h> /* for wchar_t      */
+#include <stdint.h> /* for uint32_t     */
 #include <stdio.h>  /* for size_t, FILE */
 #include "list.h"   /* for ll_t         */
 
-typedef struct interval_s interval_t;
-typedef struct range_s    range_t;
+typedef struct interval_s    interval_t;
+typedef struct range_s       range_t;
+typedef struct glyph_class_s glyph_class_t;
 
 struct interval_s
 {
@@ -30,6 +32,29 @@ struct range_s
   size_t end;
 };
 
+/* Associates a set of class bits to glyphs. Single-byte glyphs are   */
+/* classified by a direct table, multi-byte ones by a small hash set. */
+/* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+struct glyph_class_s
+{
+  unsigned char  byte_class[256]; /* class bits of single-byte glyphs.  */
+  uint32_t      *mb_keys;         /* packed multi-byte glyphs, 0=free.  */
+  unsigned char *mb_class;        /* class bits of the packed glyphs.   */
+  size_t         mb_size;         /* size of the set (power of 2).      */
+  size_t         mb_count;        /* number of multi-byte glyphs.       */
+  unsigned char  span_mask;       /* class bits stopping a span.        */
+  unsigned char  span_bytes[8];   /* ASCII bytes having these bits.     */
+  int            span_nb;         /* their number or -1 if they cannot  *
+                                   | be scanned with vector compares.   */
+};
+
+/* Returns the class bits of the nul-terminated glyph g. */
+/* """"""""""""""""""""""""""""""""""""""""""""""""""""" */
+#define GLYPH_CLASS(gc, g)                     \
+  ((g)[0] == '\0' || (g)[1] == '\0'            \
+     ? (gc)->byte_class[(unsigned char)(g)[0]] \
+     : glyph_class_get_mb(gc, g))
+
 interval_t *
 interval_new(void);
 
@@ -63,6 +88,9 @@ my_strcpy(char *dst, char *src);
 int
 isprint7(int i);
 
+int
+isprint7_str(const char *s, size_t n);
+
 int
 isprint8(int i);
 
@@ -84,8 +112,8 @@ hexdump(const char *buf, FILE *fp, const char *prefix, size_t size);
 int
 my_wcswidth(const wchar_t *s, size_t n);
 
-long
-get_sorted_array_target_pos(long *array, long nb, long value);
+size_t
+my_wcswidth_fit(const wchar_t *s, size_t n, int max, int *width);
 
 int
 is_in_foreground_process_group(void);
@@ -96,4 +124,25 @@ isempty_non_utf8(const unsigned char *s);
 int
 isempty_utf8(const unsigned char *s);
 
+glyph_class_t *
+glyph_class_new(void);
+
+void
+glyph_class_free(glyph_class_t *gc);
+
+void
+glyph_class_add(glyph_class_t *gc, const char *glyph, unsigned char flags);
+
+void
+glyph_class_add_list(glyph_class_t *gc, ll_t *list, unsigned char flags);
+
+unsigned char
+glyph_class_get_mb(glyph_class_t *gc, const char *glyph);
+
+void
+glyph_class_prepare_span(glyph_class_t *gc, unsigned char mask);
+
+size_t
+glyph_class_span(glyph_class_t *gc, const unsigned char *s, size_t n);
+
 #endif
@@ -0,0 +1,17 @@
+/* ################################################################### */
+/* Copyright 2015, Pierre Gentile (p.gen.progs@gmail.com)              */
+/*                                                                     */
+/* This Source Code Form is subject to the terms of the Mozilla Public */
+/* License, v. 2.0. If a copy of the MPL was not distributed with this */
+/* file, You can obtain one at https://mozilla.org/MPL/2.0/.           */
+/* ################################################################### */
+
+#ifndef WIDTH_H
+#define WIDTH_H
+
+#include <stddef.h> /* for wchar_t */
+
+int
+my_wcwidth(wchar_t wc);
+
+#endif
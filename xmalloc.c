@@ -12,6 +12,7 @@
 /* employed by anyone for any purpose without restriction.           */
 /* ***************************************************************** */
 
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -172,3 +173,171 @@ xstrndup(const char *str, size_t len)
 
   return p;
 }
+
+/* ******************************************************************** */
+/* Arena functions.                                                     */
+/* An arena gives memory from large blocks by simply bumping an offset. */
+/* The memory obtained cannot be freed individually, the whole arena is */
+/* released at once. This avoids the time and space overhead of malloc  */
+/* for the many small allocations having the same lifetime.             */
+/* ******************************************************************** */
+
+/* Alignment of the memory returned by arena_alloc. */
+/* """""""""""""""""""""""""""""""""""""""""""""""" */
+#define ARENA_ALIGN (sizeof(void *) > sizeof(double) ? sizeof(void *) \
+                                                     : sizeof(double))
+
+/* ============================================================== */
+/* Creates an empty arena whose blocks will have block_size bytes */
+/* of data at least.                                              */
+/* ============================================================== */
+arena_t *
+arena_new(size_t block_size)
+{
+  arena_t *arena = xmalloc(sizeof(arena_t));
+
+  arena->head       = NULL;
+  arena->block_size = block_size;
+
+  return arena;
+}
+
+/* ===================================================================== */
+/* Gets size bytes from the arena at an offset multiple of align, which  */
+/* must be a power of 2. A new block is allocated when the current one   */
+/* is too full. A request larger than a quarter of the block size gets a */
+/* dedicated block, inserted after the current one so that the free      */
+/* space of the latter is not lost.                                      */
+/* ===================================================================== */
+static void *
+arena_get(arena_t *arena, size_t size, size_t align)
+{
+  arena_block_t *block = arena->head;
+  size_t         offset;
+
+  if (block != NULL)
+  {
+    offset = (block->used + align - 1) & ~(align - 1);
+
+    if (offset + size <= block->size)
+    {
+      block->used = offset + size;
+
+      return block->data + offset;
+    }
+  }
+
+  if (size > arena->block_size / 4 && block != NULL)
+  {
+    arena_block_t *large = xmalloc(sizeof(arena_block_t) + size);
+
+    large->size = large->used = size;
+    large->next = block->next;
+    block->next = large;
+
+    return large->data;
+  }
+
+  block = xmalloc(sizeof(arena_block_t)
+                  + (size > arena->block_size ? size : arena->block_size));
+
+  block->size = size > arena->block_size ? size : arena->block_size;
+  block->used = size;
+  block->next = arena->head;
+  arena->head = block;
+
+  return block->data;
+}
+
+/* ================================================================== */
+/* Gets size bytes from the arena, suitably aligned for any type used */
+/* in smenu.                                                          */
+/* ================================================================== */
+void *
+arena_alloc(arena_t *arena, size_t size)
+{
+  return arena_get(arena, size > 0 ? size : 1, ARENA_ALIGN);
+}
+
+/* ===================================================== */
+/* Gets zeroed memory for an array of n elements of size */
+/* bytes from the arena.                                 */
+/* ===================================================== */
+void *
+arena_calloc(arena_t *arena, size_t n, size_t size)
+{
+  void *p;
+
+  if (size > 0 && n > SIZE_MAX / size)
+  {
+    fprintf(stderr,
+            "Error: Insufficient memory (attempt to calloc %zu elements of "
+            "%zu bytes)\n",
+            n,
+            size);
+
+    exit(EXIT_FAILURE);
+  }
+
+  p = arena_alloc(arena, n * size);
+
+  memset(p, '\0', n * size);
+
+  return p;
+}
+
+/* =========================================================== */
+/* strdup implementation using the arena. Strings need no      */
+/* alignment so that they are packed together without padding. */
+/* =========================================================== */
+char *
+arena_strdup(arena_t *arena, const char *str)
+{
+  size_t len = strlen(str);
+  char  *p   = arena_get(arena, len + 1, 1);
+
+  memcpy(p, str, len + 1);
+
+  return p;
+}
+
+/* =================================================== */
+/* strndup implementation using the arena.             */
+/* This version guarantees that there is a final '\0'. */
+/* =================================================== */
+char *
+arena_strndup(arena_t *arena, const char *str, size_t len)
+{
+  char *p;
+
+  p = memchr(str, '\0', len);
+
+  if (p != NULL)
+    len = p - str;
+
+  p = arena_get(arena, len + 1, 1);
+
+  memcpy(p, str, len);
+  p[len] = '\0';
+
+  return p;
+}
+
+/* ======================================================== */
+/* Releases at once all the memory obtained from the arena. */
+/* ======================================================== */
+void
+arena_free(arena_t *arena)
+{
+  arena_block_t *block = arena->head;
+
+  while (block != NULL)
+  {
+    arena_block_t *next = block->next;
+
+    free(block);
+    block = next;
+  }
+
+  free(arena);
+}
@@ -3,6 +3,27 @@
 
 #include <stddef.h>
 
+typedef struct arena_block_s arena_block_t;
+typedef struct arena_s       arena_t;
+
+/* Block of memory from which the arena allocations are carved. */
+/* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+struct arena_block_s
+{
+  arena_block_t *next; /* previously allocated block.             */
+  size_t         size; /* number of bytes available in data.      */
+  size_t         used; /* number of bytes already given in data.  */
+  char           data[];
+};
+
+/* Bump allocator for data which are all released at the same time. */
+/* """""""""""""""""""""""""""""""""""""""""""""""""""""""""""""""" */
+struct arena_s
+{
+  arena_block_t *head;       /* block in which to allocate first.       */
+  size_t         block_size; /* default size of the data of the blocks. */
+};
+
 void *
 rpl_malloc(size_t size);
 
@@ -24,4 +45,22 @@ xstrdup(const char *p);
 char *
 xstrndup(const char *str, size_t len);
 
+arena_t *
+arena_new(size_t block_size);
+
+void *
+arena_alloc(arena_t *arena, size_t size);
+
+void *
+arena_calloc(arena_t *arena, size_t n, size_t size);
+
+char *
+arena_strdup(arena_t *arena, const char *str);
+
+char *
+arena_strndup(arena_t *arena, const char *str, size_t len);
+
+void
+arena_free(arena_t *arena);
+
 #endif